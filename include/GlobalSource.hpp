@@ -9,14 +9,55 @@
 #include <algorithm>
 #include <unordered_set>
 
+#include "libs/frameslib/include/feature_schema.hpp"
+
 namespace WiFiClassifier { namespace global_vars {
     static const size_t packetsAmountThreshold = 200;
     static const size_t n_features = 27;
     static const std::string modelDataPath = "/data_raw/features.csv";
     static const std::string modelParamsPath = "/models/rf.log";
+    static const std::string generatedModelPath = "/models/rf_generated.cpp";
     static const std::string probabilityModelPath = "/models/prob.log";
     static const std::string transformerPath = "/models/transformer.log";
+    static const std::string binaryModelsPath = "/models/models.bin";
     static const std::unordered_set<size_t> skippedFeatures = { 2, 15 };
+    /// Features of packet classifier.
+    using PacketFeatures = frameslib::features::AllFeatures;
+    /// Features of observations of probability model, all except `skippedFeatures`.
+    using ObservationFeatures = frameslib::features::FeatureSchema<
+            frameslib::features::FeatureId::PivotSize,
+            frameslib::features::FeatureId::PM,
+            frameslib::features::FeatureId::SizeMin,
+            frameslib::features::FeatureId::SizeMax,
+            frameslib::features::FeatureId::SizeMean,
+            frameslib::features::FeatureId::SizeMedian,
+            frameslib::features::FeatureId::SizeMedianAD,
+            frameslib::features::FeatureId::SizeSkewness,
+            frameslib::features::FeatureId::SizeKurtosys,
+            frameslib::features::FeatureId::SizePSkewness,
+            frameslib::features::FeatureId::SizeMSquare,
+            frameslib::features::FeatureId::SizeRootMeanSquare,
+            frameslib::features::FeatureId::SizeVariance,
+            frameslib::features::FeatureId::SizeStandardDeviation,
+            frameslib::features::FeatureId::IntervalMax,
+            frameslib::features::FeatureId::IntervalMean,
+            frameslib::features::FeatureId::IntervalMedian,
+            frameslib::features::FeatureId::IntervalMedianAD,
+            frameslib::features::FeatureId::IntervalSkewness,
+            frameslib::features::FeatureId::IntervalKurtosys,
+            frameslib::features::FeatureId::IntervalPSkewness,
+            frameslib::features::FeatureId::IntervalMSquare,
+            frameslib::features::FeatureId::IntervalRootMeanSquare,
+            frameslib::features::FeatureId::IntervalVariance,
+            frameslib::features::FeatureId::IntervalStandardDeviation>;
+    static_assert(PacketFeatures::size == n_features, "Packet classifier uses all features");
+    static_assert(ObservationFeatures::size == n_features - 2, "Observations skip two features");
+#ifdef KORS_SINGLE_PRECISION
+    /// Features, forest and observations are computed in float by default.
+    static const bool singlePrecision = true;
+#else
+    static const bool singlePrecision = false;
+#endif
     static const std::string spModelParamsPath = "/models/rf_sp.log";
     static const std::string tmpDataSource = "/data_raw/data_tmp.log";
     static const size_t extraThreadsAmount = std::max(size_t(1), size_t(std::thread::hardware_concurrency() - 1));
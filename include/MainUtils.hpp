@@ -6,8 +6,11 @@
 #include "libs/frameslib/include/statistics.hpp"
 #include "libs/frameslib/include/worker.hpp"
 #include "libs/frameslib/include/syncworker.hpp"
+#include "libs/frameslib/include/sketch_features.hpp"
+#include "libs/mllib/include/random_forest.hpp"
 
 #include "GlobalSource.hpp"
+#include "interlayer.hpp"
 
 namespace WiFiClassifier {
 /**
@@ -70,6 +73,61 @@ namespace WiFiClassifier {
  * @param frames reference to stream of frames.
  */
     void workWithDataFrames(std::vector<frameslib::frames::LogFrame> &frames);
+/**
+ * Compare predictions of random forest on exact features and on features
+ * with median and MAD from quantile sketch.
+ *
+ * @param frames reference to stream of frames.
+ */
+    void validateSketchFeatures(std::vector<frameslib::frames::LogFrame> &frames);
+/**
+ * Compare double and single-precision inference: predictions of random forest
+ * and observations of every prefix for probability model.
+ *
+ * @param frames reference to stream of frames.
+ */
+    void validateSinglePrecision(std::vector<frameslib::frames::LogFrame> &frames);
+/**
+ * Measure training of random forest on `modelDataPath` for every amount of jobs:
+ * wall time, speedup over the first amount, peak resident memory and whether
+ * the same forest comes out.
+ *
+ * @param jobs amounts of jobs, e.g. 1, 2, 4, 8;
+ * @param n_estimators amount of trees;
+ * @param max_bins amount of bins of features, 0 for exact splits.
+ */
+    void benchmarkForestFit(const std::vector<size_t> &jobs, size_t n_estimators = 10, size_t max_bins = 0);
+/**
+ * Measure reading of frames from file by `SyncFrameWorker` for every amount of threads:
+ * wall time, throughput, speedup over the first amount and whether the same packets
+ * become ready. File is read into memory once, so only parsing and reassembly are measured.
+ *
+ * @param path file with frames;
+ * @param threads amounts of threads, e.g. 1, 2, 4, 8;
+ * @param oldFileFormat whether frame takes three lines.
+ */
+    void benchmarkFrameReading(const std::string &path, const std::vector<size_t> &threads, bool oldFileFormat = true);
+/**
+ * Generate C++ code of random forest from `modelParamsPath` into `generatedModelPath`.
+ *
+ * @return false if model can't be loaded.
+ */
+    bool generateModelCode();
+/**
+ * Compare predictions of generated code and random forest on training set.
+ *
+ * @param predict generated function, it is linked from `generatedModelPath`.
+ *
+ * @return true if all predictions are the same.
+ */
+    bool validateGeneratedModel(size_t (*predict)(const float *));
+/**
+ * Convert random forest, transformer and probability model from text formats
+ * into binary container `binaryModelsPath`.
+ *
+ * @return false if some model can't be loaded or container can't be written.
+ */
+    bool convertModelsToBinary();
 /**
  * Process single file with frames.
  *
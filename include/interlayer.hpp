@@ -8,6 +8,9 @@
 #include <cfloat>
 
 #include "libs/frameslib/include/worker.hpp"
+#include "libs/frameslib/include/prefix_features.hpp"
+#include "libs/frameslib/include/batch_features.hpp"
+#include "libs/frameslib/include/sketch_features.hpp"
 #include "libs/mllib/include/random_forest.hpp"
 #include "libs/mllib/include/neighbour.hpp"
 #include "libs/mllib/include/probability.hpp"
@@ -31,6 +34,7 @@ namespace WiFiClassifier {
         standard_scale_t() = default;
         standard_scale_t(const std::string &means_path, const std::string &stds_path, bool using_var = false);
         explicit standard_scale_t(std::istream &in);
+        standard_scale_t(std::vector<double> means, std::vector<double> stds);
         void load(const std::string &path);
         void load(std::istream &in);
         void load(const std::string &means_path, const std::string &stds_path, bool using_var = false);
@@ -38,6 +42,9 @@ namespace WiFiClassifier {
         void save(const std::string &path) const;
         std::vector<double> transform(const std::vector<double> &v) const;
         std::vector<double> inverse_transform(const std::vector<double> &v) const;
+        size_t size() const;
+        const std::vector<double> &get_means() const;
+        const std::vector<double> &get_stds() const;
     };
 
     class transformer_t {
@@ -46,6 +53,12 @@ namespace WiFiClassifier {
         std::vector<size_t> states = {};
         // TODO: can be Matrix<double> if we have size
         std::vector<std::vector<double>> observations = {};
+        // single-precision copies of scale and observations
+        std::vector<float> means_f = {};
+        std::vector<float> stds_f = {};
+        mllib::Matrix<float> observations_f;
+
+        void init_single_precision();
     public:
         transformer_t(const std::string &states_path,
                       const std::string &observations_path,
@@ -53,10 +66,39 @@ namespace WiFiClassifier {
                       const std::string &stds_path,
                       bool using_var = false);
         explicit transformer_t(const std::string &path);
+        transformer_t() = default;
         void save(std::ostream &out) const;
         void save(const std::string &path) const;
+        /**
+         * Add scale, states and observations' centers into binary container.
+         *
+         * @param writer container.
+         */
+        void save_binary(mllib::model_file::writer_t &writer) const;
+        /**
+         * Copy transformer from binary container.
+         *
+         * @param reader container.
+         *
+         * @return false if container has no valid transformer, the transformer is unchanged then.
+         */
+        bool load_binary(const mllib::model_file::reader_t &reader);
         size_t calc_observation(const std::vector<double> &ftrs) const;
+        /**
+         * Find the nearest observation in single precision.
+         *
+         * @param ftrs features of observation.
+         *
+         * @return id of observation, special one for NaN features.
+         */
+        size_t calc_observation(const std::vector<float> &ftrs) const;
         bool is_special(size_t observation) const;
+        /**
+         * Get amount of features of observations.
+         *
+         * @return size of scale.
+         */
+        size_t features_amount() const;
     };
 
     /**
@@ -74,8 +116,93 @@ namespace WiFiClassifier {
         std::unique_ptr<MACPredefindEstimator> macClassifier;
         std::unique_ptr<PacketEstimator> packetClassifier;
         std::unique_ptr<frameslib::frames::worker::Worker> worker;
-        std::unordered_map<MAC_t, DevType> alreadyClassified;
-        std::vector<size_t> getObservations(const std::shared_ptr<frameslib::object::PacketClassifiedObject> &obj) ;
+        /// Ids of classified devices and devices in `worker`, shared with `worker`.
+        std::shared_ptr<frameslib::object::MacTable> macs;
+        /// Types of classified devices indexed by MAC-address' id.
+        std::vector<tl::optional<DevType>> alreadyClassified;
+        /**
+         * Observations of device's packets and the window they were computed for,
+         * only prefixes which have changed since then are observed again.
+         */
+        struct ObservationCache {
+            /// Device is in `dirtyObjects`.
+            bool dirty = false;
+            /// Device is in results of not classified devices.
+            bool tracked = false;
+            /// `observations` belong to window of `amountAppended` and `amountRemoved`.
+            bool computed = false;
+            uint32_t amountAppended = 0;
+            uint32_t amountRemoved = 0;
+            /// Observation of every prefix of the window, of the raw tail only for streaming device.
+            std::vector<size_t> observations;
+            /// Amount of streamed packets seen.
+            uint64_t streamedPackets = 0;
+            /// Forward variables of probability model over observations of streamed prefixes.
+            std::vector<double> forward;
+        };
+        /// Caches of devices in worker indexed by MAC-address' id.
+        std::vector<ObservationCache> observationCache;
+        /// Ids of devices which got frames since the last poll.
+        std::vector<frameslib::object::MacTable::id_t> dirtyObjects;
+        /// Devices classified at the last poll, their classifier ID is reset at the next one.
+        std::vector<frameslib::object::MacTable::id_t> freshlyClassified;
+        /// Results of classified devices, they are updated only for devices classified since the last poll.
+        std::unordered_map<MAC_t, std::pair<std::string, uint8_t>> classifiedObjects;
+        /// Results of devices in worker.
+        std::unordered_map<MAC_t, std::pair<std::string, uint8_t>> notClassifiedObjects;
+        /// Results of all devices, classified ones have priority.
+        std::unordered_map<MAC_t, std::pair<std::string, uint8_t>> allObjects;
+        /// Features, forest and observations are computed in float.
+        bool singlePrecision = global_vars::singlePrecision;
+        bool isClassified(frameslib::object::MacTable::id_t id) const;
+        /**
+         * Classify device finally, it is released from worker.
+         *
+         * @param id id of MAC-address;
+         * @param type type of device;
+         * @param algo classifier ID of result.
+         */
+        void setClassified(frameslib::object::MacTable::id_t id, DevType type, uint8_t algo = 1);
+        void setResult(MAC_t mac, DevType type, uint8_t algo);
+        /**
+         * Mark device in worker as changed, the first one is added to results of not classified devices.
+         * Prefix of packet streamed by the frame is observed right away and folded into forward variables,
+         * so memory of streaming device doesn't grow with its observations.
+         *
+         * @param id id of MAC-address.
+         */
+        void touch(frameslib::object::MacTable::id_t id);
+        /**
+         * Observe prefixes of device's window which have changed since cache was computed.
+         * Prefixes before the last cached one are kept while packets are only appended.
+         *
+         * @param obj device in worker;
+         * @param cache cache of device.
+         */
+        void updateObservations(const frameslib::object::PacketClassifiedObject &obj, ObservationCache &cache);
+        /**
+         * Observations of all devices are computed again, e.g. by other models or precision.
+         * Streaming devices lose observations of streamed prefixes, they can't be computed again.
+         */
+        void invalidateObservations();
+        /**
+         * Predict state of device by probability model.
+         *
+         * @param cache up-to-date cache of device.
+         *
+         * @return the same state as `ProbModel::predict_state` of all observations of device.
+         */
+        size_t predictState(const ObservationCache &cache) const;
+        /**
+         * Observe features of packets.
+         *
+         * @tparam Features `PrefixFeatureEngine` or `StreamingFeatures`.
+         * @param ftrs features of prefix.
+         *
+         * @return id of observation.
+         */
+        template <class Features>
+        size_t observe(const Features &ftrs) const;
         void handleFrame(Frame &&frame);
     public:
         explicit WiFiHandler(
@@ -86,18 +213,82 @@ namespace WiFiClassifier {
         ~WiFiHandler();
         WiFiHandler& operator=(WiFiHandler&& other) noexcept;
         void setMACEstimator(std::unique_ptr<MACPredefindEstimator> macClassifier);
-        void setPacketClassifier(std::unique_ptr<PacketEstimator> estimator);
-        void setTransformer(std::unique_ptr<transformer_t> transformer);
+        /**
+         * Set packet classifier if it was trained on features of `global_vars::PacketFeatures`.
+         *
+         * @param estimator trained classifier.
+         *
+         * @return false if classifier was trained on other features or their order (other amount of them
+         * for forests saved without schema), previous one is kept then.
+         */
+        bool setPacketClassifier(std::unique_ptr<PacketEstimator> estimator);
+        /**
+         * Set transformer if it fits features of `global_vars::ObservationFeatures`.
+         *
+         * @param transformer loaded transformer.
+         *
+         * @return false if transformer uses other features, previous one is kept then.
+         */
+        bool setTransformer(std::unique_ptr<transformer_t> transformer);
         void setProbModel(std::unique_ptr<ProbModel> probModel);
+        /**
+         * Load forest, transformer and probability model from binary container.
+         * Forest is used in place of mapped file.
+         *
+         * @param path container's path.
+         *
+         * @return false if file isn't a container or some model is missing or doesn't fit features,
+         * previous models are kept then.
+         */
+        bool loadModels(const std::string &path);
+        /**
+         * Switch inference to single precision.
+         *
+         * Features are still accumulated in double and rounded once, thresholds of forest
+         * are rounded down so comparisons stay exact, probability model keeps double
+         * because its unscaled probabilities underflow float.
+         *
+         * @param enable whether float is used.
+         */
+        void setSinglePrecision(bool enable);
+        /**
+         * Switch streaming mode for devices seen after the call.
+         *
+         * Worker keeps only a short raw tail of each device and moves older packets into
+         * `frameslib::features::StreamingFeatures`, so memory of device doesn't grow with its window.
+         * Forest features and observations then take median and MAD from quantile sketches,
+         * see `frameslib::features::QuantileSketch` for their error bounds.
+         *
+         * @param enable whether devices stream.
+         */
+        void setStreaming(bool enable);
         void handleFrame(uint64_t ind_v, double Offset_v, uint32_t Size_v,
                          bool FCS_v, tl::optional<std::string> Type_v, tl::optional<std::string> SSID_v,
                          tl::optional<uint64_t> TA_v, tl::optional<uint64_t> RA_v, tl::optional<bool> moreFragments_v,
                          tl::optional<uint64_t> seqNum_v, tl::optional<uint64_t> fragNum_v);
         void handleFrame(const std::string &header, const std::string &body);
         std::string getStrWithClassifiedObjects();
-        /// Returning classification results with classifier IDs.
+        /**
+         * Classify devices which got frames since the last poll.
+         *
+         * Ready devices are classified by forest, others by probability model, both results are final.
+         * Only devices which got frames are classified, results of others are kept from previous polls.
+         * Classifier ID is 3 for forest, 2 for probability model and 1 for devices classified before this poll.
+         *
+         * @return snapshot of results of all classified devices.
+         */
         std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> getClassifiedObjects();
-        std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> getNotClassifiedObjects();
+        /**
+         * Get devices in worker which aren't classified yet.
+         *
+         * @return snapshot of results with classifier ID 0.
+         */
+        std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> getNotClassifiedObjects() const;
+        /**
+         * Classify devices and get results of all devices.
+         *
+         * @return snapshot of results of `getClassifiedObjects` and `getNotClassifiedObjects`.
+         */
         std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> getAllObjects();
     };
 }
\ No newline at end of file
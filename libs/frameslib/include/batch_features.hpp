@@ -0,0 +1,72 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include "feature_schema.hpp"
+
+namespace frameslib { namespace features {
+    /**
+     * Packets' sizes and intervals of many devices in struct-of-arrays layout.
+     *
+     * Value of packet `i` of device `d` lies at `i * lanes + d`, so one vector register
+     * holds the same packet of neighbouring devices. Moments of all devices are accumulated
+     * by AVX2 or SSE2 code chosen at runtime, with scalar fallback; each lane repeats
+     * `MomentAccumulator::add` operation by operation, so features equal
+     * `excludeFeaturesFromPackets` bit for bit. Median, MAD and pivot are found per device.
+     */
+    class FeatureBatch {
+    public:
+        /// Devices are padded to the multiple of widest vector.
+        static const size_t LANES = 4;
+        /// Amount of features of each device, they are written in order of `AllFeatures`.
+        static const size_t FEATURES = FEATURES_AMOUNT;
+        /// Kind of code which accumulates moments.
+        enum Kernel {
+            Scalar = 0,
+            SSE2,
+            AVX2
+        };
+    private:
+        size_t devices = 0;
+        size_t lanes = 0;
+        size_t maxLength = 0;
+        std::vector<uint32_t> lengths;
+        std::vector<double> sizes;
+        std::vector<double> intervals;
+
+        template <typename T>
+        void writeFeatures(T *out, size_t stride, Kernel kernel) const;
+    public:
+        /**
+         * Transpose packets' columns of devices.
+         *
+         * @param histories non-empty histories of devices.
+         */
+        explicit FeatureBatch(const std::vector<const packet::PacketHistory *> &histories);
+        size_t size() const;
+        /**
+         * Get the best kernel supported by processor.
+         *
+         * @return kernel.
+         */
+        static Kernel detectKernel();
+        /**
+         * Write features of every device into rows of matrix.
+         *
+         * @param out row-major matrix with at least `size()` rows;
+         * @param stride distance between rows, not less than `FEATURES`;
+         * @param kernel code which accumulates moments.
+         */
+        void calcFeatures(double *out, size_t stride = FEATURES, Kernel kernel = detectKernel()) const;
+        /**
+         * Write single-precision features of every device into rows of matrix.
+         * Features are computed in double and rounded once.
+         *
+         * @param out row-major matrix with at least `size()` rows;
+         * @param stride distance between rows, not less than `FEATURES`;
+         * @param kernel code which accumulates moments.
+         */
+        void calcFeatures(float *out, size_t stride = FEATURES, Kernel kernel = detectKernel()) const;
+    };
+} }
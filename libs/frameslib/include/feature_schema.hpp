@@ -0,0 +1,236 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include "features.hpp"
+
+namespace frameslib { namespace features {
+    /**
+     * Feature in order of `excludeFeaturesFromPackets`.
+     */
+    enum class FeatureId : size_t {
+        PivotSize = 0,
+        PM,
+        PT,
+        SizeMin,
+        SizeMax,
+        SizeMean,
+        SizeMedian,
+        SizeMedianAD,
+        SizeSkewness,
+        SizeKurtosys,
+        SizePSkewness,
+        SizeMSquare,
+        SizeRootMeanSquare,
+        SizeVariance,
+        SizeStandardDeviation,
+        IntervalMin,
+        IntervalMax,
+        IntervalMean,
+        IntervalMedian,
+        IntervalMedianAD,
+        IntervalSkewness,
+        IntervalKurtosys,
+        IntervalPSkewness,
+        IntervalMSquare,
+        IntervalRootMeanSquare,
+        IntervalVariance,
+        IntervalStandardDeviation
+    };
+    /// Amount of all features.
+    const size_t FEATURES_AMOUNT = 27;
+
+    /**
+     * Compile-time list of features which model uses.
+     *
+     * Offsets of features in output are fixed at compile time, groups of features
+     * which aren't in the list (pivot, moments, median, MAD) aren't computed at all.
+     * Features equal to the same ones of `excludeFeaturesFromPackets`.
+     *
+     * @tparam Ids features in order of output.
+     */
+    template <FeatureId... Ids>
+    class FeatureSchema {
+    public:
+        static constexpr size_t size = sizeof...(Ids);
+        static_assert(size > 0, "Schema must contain at least one feature");
+    private:
+        static constexpr size_t id(FeatureId ftr) {
+            return static_cast<size_t>(ftr);
+        }
+        static constexpr bool hasAny(FeatureId first, FeatureId last) {
+            constexpr FeatureId ids[] = {Ids...};
+            for (size_t i = 0; i < size; i++)
+                if (id(first) <= id(ids[i]) && id(ids[i]) <= id(last))
+                    return true;
+            return false;
+        }
+        static double value(FeatureId ftr, const double *unique,
+                            const StandardFeatures &sizes, const StandardFeatures &intervals) {
+            if (ftr <= FeatureId::PT)
+                return unique[id(ftr)];
+            const StandardFeatures &group = ftr <= FeatureId::SizeStandardDeviation ? sizes : intervals;
+            switch ((id(ftr) - id(FeatureId::SizeMin)) % 12) {
+                case 0: return group.getMin();
+                case 1: return group.getMax();
+                case 2: return group.getMean();
+                case 3: return group.getMedian();
+                case 4: return group.getMedianAD();
+                case 5: return group.getSkewness();
+                case 6: return group.getKurtosys();
+                case 7: return group.getPSkewness();
+                case 8: return group.getMSquare();
+                case 9: return group.getRootMeanSquare();
+                case 10: return group.getVariance();
+                default: return group.getStandardDeviation();
+            }
+        }
+        /**
+         * Make features of values in the buffer.
+         *
+         * @param scratch buffer with values, it is overwritten;
+         * @param moments, median, medianAD which parts are needed.
+         *
+         * @return features, parts which aren't needed are NaN or zero.
+         */
+        static StandardFeatures calcGroup(std::vector<double> &scratch, bool moments, bool median, bool medianAD) {
+            MomentAccumulator acc;
+            if (moments)
+                for (double x : scratch)
+                    acc.add(x);
+            double median_v = NAN, medianAD_v = NAN;
+            if (median) {
+                median_v = utils::calcMedian(scratch);
+                if (medianAD) {
+                    for (double &x : scratch)
+                        x = std::fabs(x - median_v);
+                    medianAD_v = utils::calcMedian(scratch);
+                }
+            }
+            return {acc, median_v, medianAD_v};
+        }
+    public:
+        /**
+         * Get position of feature in output.
+         *
+         * @param ftr feature.
+         *
+         * @return offset of `ftr` or `size` if schema doesn't contain it.
+         */
+        static constexpr size_t offset(FeatureId ftr) {
+            constexpr FeatureId ids[] = {Ids...};
+            for (size_t i = 0; i < size; i++)
+                if (ids[i] == ftr)
+                    return i;
+            return size;
+        }
+        /**
+         * Get identifier of schema, it differs for other features or their order.
+         *
+         * @return FNV-1a hash of features' ids, never zero.
+         */
+        static constexpr uint64_t hash() {
+            constexpr FeatureId ids[] = {Ids...};
+            uint64_t h = 14695981039346656037ULL;
+            for (size_t i = 0; i < size; i++) {
+                h ^= uint64_t(id(ids[i]));
+                h *= 1099511628211ULL;
+            }
+            return h == 0 ? 1 : h;
+        }
+        static constexpr bool has(FeatureId ftr) {
+            return offset(ftr) != size;
+        }
+        static constexpr bool needsUnique() {
+            return hasAny(FeatureId::PivotSize, FeatureId::PT);
+        }
+        static constexpr bool needsSizes() {
+            return hasAny(FeatureId::SizeMin, FeatureId::SizeStandardDeviation);
+        }
+        static constexpr bool needsSizeMedian() {
+            return has(FeatureId::SizeMedian) || has(FeatureId::SizeMedianAD) || has(FeatureId::SizePSkewness);
+        }
+        static constexpr bool needsIntervals() {
+            return hasAny(FeatureId::IntervalMin, FeatureId::IntervalStandardDeviation);
+        }
+        static constexpr bool needsIntervalMedian() {
+            return has(FeatureId::IntervalMedian) || has(FeatureId::IntervalMedianAD) ||
+                   has(FeatureId::IntervalPSkewness);
+        }
+        /**
+         * Write features of schema from computed groups.
+         *
+         * @param unique pivot size, PM and PT;
+         * @param sizes features of sizes;
+         * @param intervals features of intervals;
+         * @param out at least `size` values, `double` or `float` rounded from computed doubles.
+         */
+        template <typename T>
+        static void fill(const double *unique, const StandardFeatures &sizes,
+                         const StandardFeatures &intervals, T *out) {
+            size_t pos = 0;
+            int expand[] = {(out[pos++] = T(value(Ids, unique, sizes, intervals)), 0)...};
+            (void) expand;
+        }
+        /**
+         * Make features of packets.
+         *
+         * @param history non-empty packets' columns;
+         * @param out at least `size` values, `double` or `float`.
+         */
+        template <typename T>
+        static void extract(const packet::PacketHistory &history, T *out) {
+            double unique[3] = {NAN, NAN, NAN};
+            if (needsUnique()) {
+                UniqueFeatures ftrs(history.getSizes());
+                unique[0] = ftrs.getPivotSize();
+                unique[1] = ftrs.getPM();
+                unique[2] = ftrs.getPT();
+            }
+            std::vector<double> scratch;
+            StandardFeatures sizes(MomentAccumulator(), NAN, NAN), intervals(MomentAccumulator(), NAN, NAN);
+            if (needsSizes()) {
+                scratch.assign(history.getSizes().begin(), history.getSizes().end());
+                sizes = calcGroup(scratch, true, needsSizeMedian(), has(FeatureId::SizeMedianAD));
+            }
+            if (needsIntervals()) {
+                const std::vector<double> &offsets = history.getOffsets();
+                scratch.resize(offsets.size());
+                for (size_t i = offsets.size() - 1; i > 0; i--)
+                    scratch[i] = offsets[i] - offsets[i - 1];
+                scratch[0] = history.getArrivalTimes()[0];
+                intervals = calcGroup(scratch, true, needsIntervalMedian(), has(FeatureId::IntervalMedianAD));
+            }
+            fill(unique, sizes, intervals, out);
+        }
+        /**
+         * Make vector of features of packets.
+         *
+         * @param history non-empty packets' columns.
+         *
+         * @return vector of `size` features.
+         */
+        static std::vector<double> extract(const packet::PacketHistory &history) {
+            std::vector<double> out(size);
+            extract(history, out.data());
+            return out;
+        }
+    };
+
+    template <FeatureId... Ids>
+    constexpr size_t FeatureSchema<Ids...>::size;
+
+    /// All features in order of `excludeFeaturesFromPackets`.
+    using AllFeatures = FeatureSchema<
+            FeatureId::PivotSize, FeatureId::PM, FeatureId::PT,
+            FeatureId::SizeMin, FeatureId::SizeMax, FeatureId::SizeMean, FeatureId::SizeMedian,
+            FeatureId::SizeMedianAD, FeatureId::SizeSkewness, FeatureId::SizeKurtosys, FeatureId::SizePSkewness,
+            FeatureId::SizeMSquare, FeatureId::SizeRootMeanSquare, FeatureId::SizeVariance,
+            FeatureId::SizeStandardDeviation,
+            FeatureId::IntervalMin, FeatureId::IntervalMax, FeatureId::IntervalMean, FeatureId::IntervalMedian,
+            FeatureId::IntervalMedianAD, FeatureId::IntervalSkewness, FeatureId::IntervalKurtosys,
+            FeatureId::IntervalPSkewness, FeatureId::IntervalMSquare, FeatureId::IntervalRootMeanSquare,
+            FeatureId::IntervalVariance, FeatureId::IntervalStandardDeviation>;
+    static_assert(AllFeatures::size == FEATURES_AMOUNT, "AllFeatures must list every feature");
+} }
@@ -13,6 +13,54 @@
 #include "utils.hpp"
 
 namespace frameslib { namespace features {
+    /**
+     * Single-pass accumulator of minimum, maximum and the first four moments.
+     *
+     * Central moments are updated by Welford/Terriberry formulas, so values can be
+     * added one at a time, and two accumulators can be merged.
+     */
+    class MomentAccumulator {
+    private:
+        double n = 0;
+        double sum = 0;
+        double sumSquares = 0;
+        double runningMean = 0;
+        /// Sums of powers of deviations from the mean.
+        double M2 = 0, M3 = 0, M4 = 0;
+        double min = 0;
+        double max = 0;
+    public:
+        MomentAccumulator() = default;
+        /**
+         * Restore accumulator from its state.
+         *
+         * @param n amount of values;
+         * @param sum sum of values;
+         * @param sumSquares sum of squared values;
+         * @param mean running mean;
+         * @param M2, M3, M4 sums of powers of deviations from the mean;
+         * @param min, max extreme values.
+         */
+        MomentAccumulator(double n, double sum, double sumSquares, double mean,
+                          double M2, double M3, double M4, double min, double max);
+        void add(double x);
+        /**
+         * Add values of another accumulator.
+         *
+         * @param other accumulator of other values.
+         */
+        void merge(const MomentAccumulator &other);
+        size_t getCount() const;
+        double getMin() const;
+        double getMax() const;
+        /// Mean as sum / n.
+        double getMean() const;
+        double getMSquare() const;
+        double getVariance() const;
+        double getThirdMoment() const;
+        double getFourthMoment() const;
+    };
+
     class StandardFeatures {
     private:
         double standardDeviation;
@@ -28,7 +76,15 @@ namespace frameslib { namespace features {
         double median;
         double medianAD;
     public:
-        explicit StandardFeatures(std::vector<double> xs = {});
+        explicit StandardFeatures(const std::vector<double> &xs = {});
+        /**
+         * Make features from accumulated moments.
+         *
+         * @param acc accumulator of all values;
+         * @param median median of values;
+         * @param medianAD median absolute deviation of values.
+         */
+        StandardFeatures(const MomentAccumulator &acc, double median, double medianAD);
         std::string toString() const;
         std::vector<double> toVector();
         double getStandardDeviation() const;
@@ -51,6 +107,8 @@ namespace frameslib { namespace features {
         double PT;
     public:
         explicit UniqueFeatures(const std::vector<packet::Packet>& packets = {});
+        explicit UniqueFeatures(const packet::PacketHistory& history);
+        explicit UniqueFeatures(const std::vector<uint32_t>& sizes);
         std::string toString() const;
         std::vector<double> toVector();
         double getPivotSize() const;
@@ -65,6 +123,14 @@ namespace frameslib { namespace features {
      * @return vector of features.
      */
     std::vector<double> excludeFeaturesFromPackets(const std::vector<packet::Packet> &packets);
+    /**
+     * Make vector of features.
+     *
+     * @param history reference to packets' columns.
+     *
+     * @return vector of features.
+     */
+    std::vector<double> excludeFeaturesFromPackets(const packet::PacketHistory &history);
     /**
      * Make vector of features with skipping some of them.
      *
@@ -75,4 +141,14 @@ namespace frameslib { namespace features {
      */
     std::vector<double> excludeFeaturesFromPacketsWithSkips(const std::vector<packet::Packet> &packets,
                                                             const std::unordered_set<size_t> &skips = {});
+    /**
+     * Make vector of features with skipping some of them.
+     *
+     * @param history reference to packets' columns;
+     * @param skips indexes.
+     *
+     * @return vector of features.
+     */
+    std::vector<double> excludeFeaturesFromPacketsWithSkips(const packet::PacketHistory &history,
+                                                            const std::unordered_set<size_t> &skips = {});
 } }
\ No newline at end of file
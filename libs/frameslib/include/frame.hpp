@@ -276,6 +276,15 @@ namespace frameslib { namespace frames {
                    bool hasHeader = true,
                    bool hasBody = true,
                    bool oldFileFormat = true);
+    /**
+     * Find TA in decoded data of frame without regular expressions, the same one `parse` finds in correct frame.
+     * It is cheap enough to route frames before they are parsed.
+     *
+     * @param info decoded data line.
+     *
+     * @return TA or nothing if line has no one.
+     */
+    tl::optional<uint64_t> findTA(const std::string &info);
     /**
      * Fill vector with LogFrames from file.
      *
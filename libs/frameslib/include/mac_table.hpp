@@ -0,0 +1,51 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <unordered_map>
+
+#include "object.hpp"
+
+namespace frameslib { namespace object {
+    /**
+     * Interning of MAC-addresses into dense ids.
+     *
+     * MAC-address is hashed once at ingestion, after that per-device tables
+     * are plain vectors indexed by id. Ids are never reused, so only MAC-addresses
+     * which tables keep something for should be interned.
+     */
+    class MacTable {
+    public:
+        typedef uint32_t id_t;
+        /// Id of unknown MAC-address.
+        static const id_t NONE;
+    private:
+        std::unordered_map<MAC_t, id_t> ids;
+        std::vector<MAC_t> macs;
+    public:
+        MacTable() = default;
+        /**
+         * Get id of MAC-address, give new one if it is unknown.
+         *
+         * @param mac MAC-address.
+         *
+         * @return id of `mac`.
+         */
+        id_t intern(MAC_t mac);
+        /**
+         * Get id of known MAC-address.
+         *
+         * @param mac MAC-address.
+         *
+         * @return id of `mac` or `NONE`.
+         */
+        id_t find(MAC_t mac) const;
+        MAC_t getMAC(id_t id) const;
+        /// Amount of known MAC-addresses.
+        size_t size() const;
+        /// Upper bound of given ids, size for tables indexed by id.
+        size_t range() const;
+        void clear();
+    };
+} }
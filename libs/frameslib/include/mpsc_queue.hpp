@@ -0,0 +1,71 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace frameslib {
+    /**
+     * Unbounded lock-free queue for many producer threads and one consumer thread.
+     *
+     * Producers link their nodes with one atomic exchange, so push never waits for other threads.
+     * Element pushed while another push is between its exchange and link is seen by consumer
+     * only after that push completes.
+     * Elements of one producer are popped in the order of their pushes.
+     */
+    template <typename T>
+    class MPSCQueue {
+    protected:
+        struct Node {
+            std::atomic<Node *> next;
+            T value;
+
+            explicit Node(T value = T()) : next(nullptr), value(std::move(value)) {}
+        };
+
+        /// The last pushed node, exchanged by producers.
+        alignas(64) std::atomic<Node *> _head;
+        /// Node before the front element, its value was popped already; consumer only.
+        alignas(64) Node *_tail;
+    public:
+        MPSCQueue() {
+            _tail = new Node();
+            _head.store(_tail, std::memory_order_relaxed);
+        }
+        MPSCQueue(const MPSCQueue &) = delete;
+        MPSCQueue& operator=(const MPSCQueue &) = delete;
+        ~MPSCQueue() {
+            T value;
+            while (tryPop(value));
+            delete _tail;
+        }
+        /**
+         * Push element (any thread).
+         *
+         * @param value element.
+         */
+        void push(T value) {
+            Node *node = new Node(std::move(value));
+            Node *prev = _head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+        /**
+         * Pop the front element (consumer only).
+         *
+         * @param value reference for the result.
+         *
+         * @return false if there are no completely pushed elements.
+         */
+        bool tryPop(T &value) {
+            Node *next = _tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            value = std::move(next->value);
+            delete _tail;
+            _tail = next;
+            return true;
+        }
+    };
+}
@@ -5,6 +5,7 @@
 
 #include "frame.hpp"
 #include "packet.hpp"
+#include "sketch_features.hpp"
 
 namespace frameslib { namespace object {
     using MAC_t = uint64_t;
@@ -100,23 +101,80 @@ namespace frameslib { namespace object {
         void setFeature(SimpleFeature ftr);
     };
 
+    /**
+     * Fixed-capacity ring buffer with packets of one MAC-address.
+     *
+     * Packets are stored column by column: sequence numbers, sizes, offsets,
+     * arrival times and amounts of fragments lie in separate arrays.
+     * Removing from the front takes O(1), removing from the middle only marks the slot as tombstone.
+     * Tombstones are squeezed out lazily: when packets are extracted or when the ring is full.
+     * If the ring is full of alive packets the oldest one is overwritten.
+     */
     class PacketCollection {
     private:
-        std::vector<packet::Packet> packets = {};
+        /// Mark of removed slot in `gaps`.
+        static const uint32_t TOMBSTONE;
+        /// Size of every column, the capacity of collection.
+        size_t cap = 0;
+        /// One block for all columns, so collection takes a single allocation.
+        std::unique_ptr<uint8_t[]> storage;
+        double *offsets = nullptr;
+        double *arrivalTimes = nullptr;
+        uint32_t *sizes = nullptr;
+        /// Amount of tombstones right before each alive slot or `TOMBSTONE` for removed slot.
+        uint32_t *gaps = nullptr;
+        uint16_t *seqNums = nullptr;
+        uint16_t *fragsAmounts = nullptr;
+        /// Physical index of the first alive packet.
+        size_t head = 0;
+        /// Amount of slots (alive and removed) between the first and the last alive packets.
+        size_t used = 0;
+        /// Amount of alive packets.
+        size_t alive = 0;
+
+        size_t slot(size_t pos) const;
+        size_t locate(size_t id, size_t &next) const;
+        size_t physical(size_t id) const;
+        static size_t storageSize(size_t capacity);
+        void bind();
+        void compact();
     public:
-        explicit PacketCollection() = default;
-        explicit PacketCollection(size_t packetsAmountThreshold);
+        explicit PacketCollection(size_t packetsAmountThreshold = 200);
         explicit PacketCollection(PacketCollection *collection);
+        PacketCollection(const PacketCollection& collection);
         PacketCollection(PacketCollection&& collection) noexcept;
         PacketCollection& operator=(const PacketCollection& collection);
         PacketCollection& operator=(PacketCollection&& collection) noexcept;
         ~PacketCollection();
-        bool empty();
-        void addPacket(packet::Packet &pack);
+        bool empty() const;
+        size_t size() const;
+        size_t capacity() const;
+        void addPacket(const packet::Packet &pack);
+        /**
+         * Add fragment to the last packet if it belongs to it.
+         *
+         * @param frame fragment of the last packet.
+         */
+        void addFragment(frames::LogFrame *frame);
         void removeByIndex(size_t id);
         void removeFirstPackets(size_t cnt);
-        const std::vector<packet::Packet>& getPackets() const;
-        packet::Packet& getPacket(size_t id);
+        uint64_t getSeqNum(size_t id) const;
+        uint64_t getSize(size_t id) const;
+        double getOffset(size_t id) const;
+        void setArrivalTime(size_t id, double time);
+        /**
+         * Get alive packets in arrival order.
+         *
+         * @return compacted copy of packets' columns.
+         */
+        packet::PacketHistory getHistory() const;
+        /**
+         * Get alive packets in arrival order.
+         *
+         * @return compacted copy of packets.
+         */
+        std::vector<packet::Packet> getPackets() const;
+        packet::Packet getPacket(size_t id) const;
     };
 
     /**
@@ -129,12 +187,28 @@ namespace frameslib { namespace object {
         DeviceType type;
         bool ready = false;
         bool needCut = true;
+        /// Amount of first packets which were cut, including ones overwritten in full ring before the cut.
         uint32_t amountCutPackets = 0;
-        std::unique_ptr<PacketCollection> packets;
+        /// Amount of packets and fragments appended to the window.
+        uint32_t amountAppended = 0;
+        /// Amount of changes of packets already in the window: removing from any place or rewriting arrival time.
+        uint32_t amountRemoved = 0;
+        PacketCollection packets;
+        /// Features of packets which left the raw tail in streaming mode, nullptr otherwise.
+        std::unique_ptr<features::StreamingFeatures> stream;
     public:
+        /**
+         * Make object without packets.
+         *
+         * @param mac MAC-address;
+         * @param type type of device;
+         * @param packetsAmountThreshold capacity of raw packets;
+         * @param streaming whether old packets are moved into `StreamingFeatures` and their raw values are dropped.
+         */
         explicit PacketClassifiedObject(MAC_t mac = 0xffffffffffff,
                                         DeviceType type = Unknown,
-                                        size_t packetsAmountThreshold = 200);
+                                        size_t packetsAmountThreshold = 200,
+                                        bool streaming = false);
         PacketClassifiedObject(PacketClassifiedObject&& obj) noexcept ;
         PacketClassifiedObject(const PacketClassifiedObject& obj) noexcept;
         PacketClassifiedObject& operator=(PacketClassifiedObject&& obj) noexcept ;
@@ -146,14 +220,61 @@ namespace frameslib { namespace object {
         bool isPacketsEmpty() const;
         bool isReady() const;
         bool isNeedCut() const;
+        uint32_t getAmountCutPackets() const;
+        /**
+         * Get amount of appends to the window, together with `getAmountRemoved` it is version of the window.
+         *
+         * @return amount of appended packets and fragments.
+         */
+        uint32_t getAmountAppended() const;
+        /**
+         * Get amount of changes of packets which were already in the window.
+         * While it stays the same, features of every prefix but the last one are unchanged.
+         *
+         * @return amount of removals of packets and rewrites of arrival times.
+         */
+        uint32_t getAmountRemoved() const;
+        /**
+         * Get amount of raw packets, only they are addressed by index.
+         *
+         * @return amount of raw packets.
+         */
+        size_t getPacketsAmount() const;
+        /**
+         * Get amount of packets in window, including streamed ones.
+         *
+         * @return amount of packets.
+         */
+        size_t getWindowSize() const;
+        /**
+         * Get features of streamed packets.
+         *
+         * @return features of packets before raw ones, nullptr if object doesn't stream.
+         */
+        const features::StreamingFeatures *getStream() const;
         std::vector<packet::Packet> getPackets() const;
-        packet::Packet& getPacket(size_t id);
+        /**
+         * Get raw packets, in streaming mode they are the tail of window.
+         *
+         * @return packets' columns.
+         */
+        packet::PacketHistory getHistory() const;
+        packet::Packet getPacket(size_t id) const;
         void setType(DeviceType newType);
         void setReady(bool ready);
         void setNeedCut(bool needCut);
         void setAmountCutPackets(uint32_t cut);
-        void addPacket(packet::Packet &pack);
+        void setArrivalTime(size_t id, double time);
+        void addPacket(const packet::Packet &pack);
+        void addFragment(frames::LogFrame *frame);
         void removeByIndex(size_t id);
         void removeFirstPackets(size_t cnt);
+        /**
+         * Move first raw packets into streaming features, window stays the same.
+         * Does nothing if object doesn't stream.
+         *
+         * @param keep amount of the last packets which stay raw.
+         */
+        void streamFirstPackets(size_t keep);
     };
 } }
\ No newline at end of file
@@ -9,25 +9,97 @@
 #include "utils.hpp"
 
 namespace frameslib { namespace packet {
+    /// Amount of fragments whose metadata is stored right inside the packet.
+    const size_t INLINE_FRAGMENTS = 4;
+
+    /**
+     * Metadata of one received fragment.
+     */
+    struct Fragment {
+        uint32_t size = 0;
+        double offset = 0;
+    };
+
     class Packet {
     protected:
         uint64_t number;
         uint64_t size;
         double offset;
         double arrivalTime;
-        std::vector<std::pair<uint64_t, double>> fragments;
+        /// Amount of received fragments (may exceed `INLINE_FRAGMENTS`).
+        uint32_t fragsAmount = 0;
+        /// Metadata of the first `INLINE_FRAGMENTS` fragments, the rest are counted only.
+        Fragment fragments[INLINE_FRAGMENTS];
+
+        void appendFragment(uint64_t size_v, double offset_v);
     public:
         explicit Packet(uint64_t id = 0, uint64_t size_v = 0, double time = 0,
-                        std::vector<std::pair<uint64_t, double>> &&frags = {});
-        ~Packet();
+                        std::initializer_list<std::pair<uint64_t, double>> frags = {});
+        /**
+         * Restore packet from stored columns, fragments' metadata isn't kept there.
+         *
+         * @param id sequence number;
+         * @param size_v size of all fragments;
+         * @param time offset of the last fragment;
+         * @param arrival arrival time;
+         * @param fragsAmount amount of received fragments.
+         */
+        Packet(uint64_t id, uint64_t size_v, double time, double arrival, uint32_t fragsAmount);
+        virtual ~Packet() = default;
         virtual void addFragment(frames::LogFrame* frame);
         uint32_t getFragSize() const;
+        /**
+         * Get metadata of stored fragment.
+         *
+         * @param id index of fragment, less than min(getFragSize(), INLINE_FRAGMENTS).
+         *
+         * @return fragment's size and offset.
+         */
+        const Fragment& getFragment(size_t id) const;
         uint64_t getSeqNum() const;
         uint64_t getSize() const;
         double getArrivalTime() const;
         double getOffset() const;
         void setArrivalTime(double time);
     };
+
+    /**
+     * Packets of one MAC-address stored column by column.
+     *
+     * Features read only sizes, offsets and arrival times,
+     * so each of them lies in its own contiguous array.
+     */
+    class PacketHistory {
+    private:
+        std::vector<uint16_t> seqNums = {};
+        std::vector<uint32_t> sizes = {};
+        std::vector<double> offsets = {};
+        std::vector<double> arrivalTimes = {};
+        std::vector<uint16_t> fragsAmounts = {};
+    public:
+        PacketHistory() = default;
+        explicit PacketHistory(const std::vector<Packet> &packets);
+        bool empty() const;
+        size_t size() const;
+        void reserve(size_t n);
+        void clear();
+        void addPacket(const Packet &pack);
+        void addPacket(uint16_t seqNum, uint32_t size, double offset, double arrivalTime, uint16_t fragsAmount);
+        /**
+         * Restore packet from columns.
+         *
+         * @param id index of packet.
+         *
+         * @return packet without fragments' metadata.
+         */
+        Packet getPacket(size_t id) const;
+        std::vector<Packet> getPackets() const;
+        const std::vector<uint16_t>& getSeqNums() const;
+        const std::vector<uint32_t>& getSizes() const;
+        const std::vector<double>& getOffsets() const;
+        const std::vector<double>& getArrivalTimes() const;
+        const std::vector<uint16_t>& getFragsAmounts() const;
+    };
     /**
     * Collect transmitions into packets and group them by TA.
     *
@@ -0,0 +1,140 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <set>
+
+#include "feature_schema.hpp"
+
+namespace frameslib { namespace features {
+    /**
+     * Multiset of values known in advance, which are added one by one.
+     *
+     * Values are compressed into ranks and counted by Fenwick tree,
+     * so adding and finding k-th smallest value take O(log n).
+     */
+    class OrderStatistics {
+    private:
+        /// Sorted unique values.
+        std::vector<double> values;
+        std::vector<uint32_t> tree;
+        size_t amount = 0;
+        size_t highBit = 0;
+
+        double kth(size_t rank) const;
+        size_t countNotGreater(double x) const;
+        double deviation(size_t id, size_t lowerAmount, double center) const;
+    public:
+        /**
+         * Make empty multiset.
+         *
+         * @param domain all values which may be added.
+         */
+        explicit OrderStatistics(std::vector<double> domain = {});
+        /**
+         * Add value.
+         *
+         * @param x value from domain.
+         */
+        void add(double x);
+        size_t size() const;
+        /**
+         * Get median of added values.
+         *
+         * @return median, the mean of two middle values for even size.
+         */
+        double median() const;
+        /**
+         * Get median absolute deviation of added values.
+         *
+         * @param center median of added values.
+         *
+         * @return median of |x - center|.
+         */
+        double medianAD(double center) const;
+    };
+
+    /**
+     * Features of every prefix of packets' history.
+     *
+     * Each step extends the previous prefix by one packet: moments are accumulated,
+     * median and MAD are taken from order statistics, pivot and MTU are tracked,
+     * so features of all prefixes take O(n log^2 n) in total instead of O(n^2 log n).
+     * Features equal to `excludeFeaturesFromPackets` of the same prefix.
+     */
+    class PrefixFeatureEngine {
+    private:
+        const packet::PacketHistory &history;
+        size_t amount = 0;
+        // UniqueFeatures
+        std::vector<uint32_t> sizeAmounts;
+        /// Pairs (-amount, size), the most frequent and the least size is the first.
+        std::set<std::pair<int64_t, uint32_t>> frequency;
+        uint64_t totalSize = 0;
+        uint64_t MTU = 0;
+        /// The first size and the first size which differs from it.
+        uint64_t firstSize = 0;
+        tl::optional<uint64_t> secondSize;
+        std::vector<uint32_t> sortedSizes;
+        // StandardFeatures
+        MomentAccumulator sizeMoments;
+        MomentAccumulator intervalMoments;
+        OrderStatistics sizeOrder;
+        OrderStatistics intervalOrder;
+
+        double getInterval(size_t id) const;
+        std::vector<double> getUniqueFeatures() const;
+    public:
+        /**
+         * Make engine with empty prefix.
+         *
+         * @param history packets' columns, they must outlive the engine.
+         */
+        explicit PrefixFeatureEngine(const packet::PacketHistory &history);
+        /**
+         * Extend prefix by the next packet.
+         *
+         * @return false if the whole history is already in prefix.
+         */
+        bool next();
+        /**
+         * Get amount of packets in prefix.
+         *
+         * @return size of prefix.
+         */
+        size_t size() const;
+        /**
+         * Write features of non-empty prefix.
+         *
+         * @tparam Schema features to write.
+         * @param out at least `Schema::size` values, `double` or `float`.
+         */
+        template <class Schema, typename T>
+        void getFeatures(T *out) const;
+    };
+} }
+
+template <class Schema, typename T>
+void frameslib::features::PrefixFeatureEngine::getFeatures(T *out) const {
+    double unique[3] = {NAN, NAN, NAN};
+    if (Schema::needsUnique()) {
+        std::vector<double> tmp = getUniqueFeatures();
+        std::copy(tmp.begin(), tmp.end(), unique);
+    }
+    double median = NAN, medianAD = NAN;
+    if (Schema::needsSizeMedian()) {
+        median = sizeOrder.median();
+        if (Schema::has(FeatureId::SizeMedianAD))
+            medianAD = sizeOrder.medianAD(median);
+    }
+    StandardFeatures sizes(sizeMoments, median, medianAD);
+    median = medianAD = NAN;
+    if (Schema::needsIntervalMedian()) {
+        median = intervalOrder.median();
+        if (Schema::has(FeatureId::IntervalMedianAD))
+            medianAD = intervalOrder.medianAD(median);
+    }
+    StandardFeatures intervals(intervalMoments, median, medianAD);
+    Schema::fill(unique, sizes, intervals, out);
+}
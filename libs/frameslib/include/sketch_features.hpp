@@ -0,0 +1,163 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include "feature_schema.hpp"
+
+namespace frameslib { namespace features {
+    /**
+     * Bounded-memory quantile sketch: log-linear histogram in a fixed array of counts.
+     *
+     * Every octave [2^(e-1), 2^e) of magnitudes is split into `SUB_BINS` equal bins,
+     * a value is represented by the middle of its bin.
+     * Error bounds, eps = 1 / (2 * SUB_BINS) = 1/32, delta = 2^MIN_EXP (about 1 microsecond of interval):
+     *  - value with 2^MIN_EXP <= |x| < 2^MAX_EXP: |x' - x| <= eps * |x|;
+     *  - value with |x| < 2^MIN_EXP is represented by zero: |x' - x| < delta;
+     *  - value with |x| >= 2^MAX_EXP (65536 bytes or seconds) is clamped into the last bin,
+     *    its error isn't bounded.
+     * Rounding is monotone, so order statistics keep the same bounds:
+     *  - median: |m' - m| <= eps * max|x| over middle values + delta;
+     *  - MAD: |MAD' - MAD| <= eps * (2 * |m| + MAD) + 2 * delta.
+     * Memory is `BINS` 32-bit counts, about 4.5 KB, whatever amount of added values;
+     * a bin counts at most 2^32 - 1 values.
+     */
+    class QuantileSketch {
+    public:
+        static const int SUB_BINS = 16;
+        static const int MIN_EXP = -20;
+        static const int MAX_EXP = 16;
+        /// Bins of positive values, bins of negative ones mirror them.
+        static const int32_t HALF_BINS = (MAX_EXP - MIN_EXP) * SUB_BINS;
+        /// Amount of bins, the middle one holds zero.
+        static const size_t BINS = 2 * HALF_BINS + 1;
+    private:
+        /// Amount of values in bins, index of bin grows with values.
+        uint32_t counts[BINS] = {};
+        uint64_t amount = 0;
+
+        /// Get bin of value, from -HALF_BINS to HALF_BINS.
+        static int32_t binOf(double x);
+        static double representative(int32_t bin);
+        double kth(uint64_t rank) const;
+    public:
+        QuantileSketch() = default;
+        void add(double x);
+        /**
+         * Add values of another sketch.
+         *
+         * @param other sketch of other values.
+         */
+        void merge(const QuantileSketch &other);
+        uint64_t size() const;
+        /**
+         * Get approximate median of added values.
+         *
+         * @return median, the mean of two middle values for even size.
+         */
+        double median() const;
+        /**
+         * Get approximate median absolute deviation of added values.
+         *
+         * @param center median of added values.
+         *
+         * @return median of |x - center|.
+         */
+        double medianAD(double center) const;
+    };
+
+    /**
+     * Features of packets' stream in constant memory, about 11 KB.
+     *
+     * Moments are exact, median and MAD come from `QuantileSketch`.
+     * Amounts of sizes for pivot size are counted in a table of `SIZES_CAPACITY` sizes (space-saving):
+     * they are exact while stream has no more distinct sizes, e.g. for any window of ready device,
+     * otherwise a new size replaces the least frequent one and inherits its amount, so amounts are
+     * overestimated by at most size() / SIZES_CAPACITY and every size more frequent than that stays in the table.
+     * Features have the same layout as `excludeFeaturesFromPacketsWithSkips`.
+     */
+    class StreamingFeatures {
+    public:
+        static const size_t SIZES_CAPACITY = 256;
+    private:
+        uint64_t amount = 0;
+        double lastOffset = 0;
+        // UniqueFeatures
+        uint32_t sizes[SIZES_CAPACITY] = {};
+        uint32_t sizeAmounts[SIZES_CAPACITY] = {};
+        /// Amount of used entries of `sizes` and `sizeAmounts`.
+        size_t sizesUsed = 0;
+        uint64_t totalSize = 0;
+        uint64_t MTU = 0;
+        /// The first size and the first size which differs from it.
+        uint64_t firstSize = 0;
+        tl::optional<uint64_t> secondSize;
+        // StandardFeatures
+        MomentAccumulator sizeMoments;
+        MomentAccumulator intervalMoments;
+        QuantileSketch sizeSketch;
+        QuantileSketch intervalSketch;
+
+        void countSize(uint32_t size);
+        /// Get counted amount of size, 0 if it isn't in the table.
+        uint64_t getSizeAmount(uint32_t size) const;
+        std::vector<double> getUniqueFeatures() const;
+    public:
+        StreamingFeatures() = default;
+        /**
+         * Add the next packet of stream.
+         *
+         * @param size size of packet;
+         * @param offset offset of packet;
+         * @param arrivalTime arrival time, it is used for the first packet only.
+         */
+        void addPacket(uint64_t size, double offset, double arrivalTime = 0);
+        /**
+         * Add all packets of history.
+         *
+         * @param history packets' columns.
+         */
+        void addPackets(const packet::PacketHistory &history);
+        uint64_t size() const;
+        /**
+         * Make vector of features of non-empty stream with skipping some of them.
+         *
+         * @param skips indexes.
+         *
+         * @return vector of features.
+         */
+        std::vector<double> getFeatures(const std::unordered_set<size_t> &skips = {}) const;
+        /**
+         * Write features of non-empty stream, median and MAD are taken from sketches.
+         *
+         * @tparam Schema features to write.
+         * @param out at least `Schema::size` values, `double` or `float`.
+         */
+        template <class Schema, typename T>
+        void getFeatures(T *out) const;
+    };
+} }
+
+template <class Schema, typename T>
+void frameslib::features::StreamingFeatures::getFeatures(T *out) const {
+    double unique[3] = {NAN, NAN, NAN};
+    if (Schema::needsUnique()) {
+        std::vector<double> tmp = getUniqueFeatures();
+        std::copy(tmp.begin(), tmp.end(), unique);
+    }
+    double median = NAN, medianAD = NAN;
+    if (Schema::needsSizeMedian()) {
+        median = sizeSketch.median();
+        if (Schema::has(FeatureId::SizeMedianAD))
+            medianAD = sizeSketch.medianAD(median);
+    }
+    StandardFeatures sizes(sizeMoments, median, medianAD);
+    median = medianAD = NAN;
+    if (Schema::needsIntervalMedian()) {
+        median = intervalSketch.median();
+        if (Schema::has(FeatureId::IntervalMedianAD))
+            medianAD = intervalSketch.medianAD(median);
+    }
+    StandardFeatures intervals(intervalMoments, median, medianAD);
+    Schema::fill(unique, sizes, intervals, out);
+}
@@ -0,0 +1,115 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace frameslib {
+    /**
+     * Pool of objects allocated by fixed-size chunks.
+     *
+     * Objects are addressed by dense 32-bit handles: `chunk * CHUNK + index`.
+     * Released handles are reused first, chunks are freed only with the pool,
+     * so objects never move and frequent creation doesn't fragment the heap.
+     */
+    template <typename T, size_t CHUNK = 256>
+    class SlabPool {
+    public:
+        typedef uint32_t handle_t;
+    protected:
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type cell_t;
+
+        std::vector<std::unique_ptr<cell_t[]>> _chunks;
+        /// Released handles, the last one is reused first.
+        std::vector<handle_t> _free;
+        std::vector<bool> _alive;
+        size_t _size = 0;
+
+        T *cell(handle_t handle) const {
+            return reinterpret_cast<T *>(&_chunks[handle / CHUNK][handle % CHUNK]);
+        }
+    public:
+        SlabPool() = default;
+        SlabPool(const SlabPool &) = delete;
+        SlabPool& operator=(const SlabPool &) = delete;
+        ~SlabPool() {
+            clear();
+        }
+        /**
+         * Construct new object in the pool.
+         *
+         * @param args arguments of T's constructor.
+         *
+         * @return handle of the object.
+         */
+        template <typename... Args>
+        handle_t create(Args&&... args) {
+            handle_t handle;
+            if (!_free.empty()) {
+                handle = _free.back();
+                _free.pop_back();
+            } else {
+                if (_alive.size() == _chunks.size() * CHUNK)
+                    _chunks.emplace_back(new cell_t[CHUNK]);
+                handle = handle_t(_alive.size());
+                _alive.push_back(false);
+            }
+            new (cell(handle)) T(std::forward<Args>(args)...);
+            _alive[handle] = true;
+            _size++;
+            return handle;
+        }
+        /**
+         * Destroy object and make its handle free.
+         *
+         * @param handle handle of alive object.
+         */
+        void release(handle_t handle) {
+            if (!isAlive(handle)) return;
+            cell(handle)->~T();
+            _alive[handle] = false;
+            _free.push_back(handle);
+            _size--;
+        }
+        T& get(handle_t handle) {
+            return *cell(handle);
+        }
+        const T& get(handle_t handle) const {
+            return *cell(handle);
+        }
+        bool isAlive(handle_t handle) const {
+            return handle < _alive.size() && _alive[handle];
+        }
+        /**
+         * Get amount of alive objects.
+         *
+         * @return amount of alive objects.
+         */
+        size_t size() const {
+            return _size;
+        }
+        /**
+         * Get upper bound of handles given so far.
+         *
+         * @return amount of used cells.
+         */
+        size_t range() const {
+            return _alive.size();
+        }
+        /**
+         * Destroy all objects, allocated chunks are kept for reuse.
+         */
+        void clear() {
+            for (handle_t handle = 0; handle < _alive.size(); handle++)
+                if (_alive[handle])
+                    cell(handle)->~T();
+            _alive.clear();
+            _free.clear();
+            _size = 0;
+        }
+    };
+}
@@ -0,0 +1,85 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace frameslib {
+    /**
+     * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+     *
+     * Capacity is rounded up to the power of two.
+     * Producer and consumer indices lie in different cache lines.
+     */
+    template <typename T>
+    class SPSCQueue {
+    protected:
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type cell_t;
+
+        std::unique_ptr<cell_t[]> _cells;
+        size_t _mask;
+        /// Index of the next element to pop, written by consumer only.
+        alignas(64) std::atomic<size_t> _head;
+        /// Index of the next free cell, written by producer only.
+        alignas(64) std::atomic<size_t> _tail;
+
+        T *cell(size_t idx) {
+            return reinterpret_cast<T *>(&_cells[idx & _mask]);
+        }
+    public:
+        explicit SPSCQueue(size_t capacity) : _head(0), _tail(0) {
+            size_t cap = 1;
+            while (cap < capacity) cap <<= 1;
+            _cells.reset(new cell_t[cap]);
+            _mask = cap - 1;
+        }
+        SPSCQueue(const SPSCQueue &) = delete;
+        SPSCQueue& operator=(const SPSCQueue &) = delete;
+        ~SPSCQueue() {
+            for (; consume([](T &) {}););
+        }
+        /**
+         * Push element if there is free space (producer only).
+         *
+         * @param value element, it isn't moved from if the queue is full.
+         *
+         * @return true if element was pushed.
+         */
+        bool tryPush(T &&value) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) > _mask)
+                return false;
+            new (cell(tail)) T(std::move(value));
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+        /**
+         * Handle the front element in place and pop it (consumer only).
+         *
+         * @param func function which takes reference to the front element.
+         *
+         * @return false if the queue was empty.
+         */
+        template <typename F>
+        bool consume(F &&func) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire))
+                return false;
+            T *value = cell(head);
+            func(*value);
+            value->~T();
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+        bool empty() const {
+            return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+        }
+        size_t capacity() const {
+            return _mask + 1;
+        }
+    };
+}
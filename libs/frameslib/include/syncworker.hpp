@@ -3,47 +3,165 @@
 //
 #pragma once
 
+#include <atomic>
+#include <bitset>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
 #include "worker.hpp"
-#include "thread_pool.hpp"
+#include "spsc_queue.hpp"
+#include "mpsc_queue.hpp"
 
 namespace frameslib { namespace frames { namespace syncworker {
-    class SyncPacket : public packet::Packet {
-    protected:
-        std::set<uint64_t> frags;
-    public:
-        explicit SyncPacket(LogFrame frame);
-        void addFragment(LogFrame *frame) override;
-    };
-
+    /**
+     * Reassembly of packets of one TA from fragments which may come slightly out of order.
+     *
+     * Packets wait in a circular reorder window indexed by `seqNum mod W` over the 12-bit sequence space.
+     * Complete packets leave the window in sequence order to the history.
+     * When a frame doesn't fit into the window, the window moves: missing packets are skipped
+     * and incomplete ones are dropped. Frames behind the window are dropped as late.
+     * Several late frames in a row or a late frame long after the last released packet mean
+     * that the sender restarted its sequence numbers: the window is flushed and jumps to the frame.
+     */
     class SyncPacketWorker {
     protected:
+        struct Slot {
+            bool used = false;
+            uint16_t seqNum = 0;
+            /// Bit i is set if fragment i was received.
+            uint16_t fragsMask = 0;
+            /// Amount of fragments, 0 while the last one isn't received.
+            uint8_t fragsTotal = 0;
+            uint32_t size = 0;
+            double offset = 0;
+
+            bool isComplete() const;
+        };
+
         bool needCut = true;
-        bool readyToWork = false;
-        std::vector<bool> readyPackets;
-        std::vector<int> expectedFragsSizes;
-        std::vector<packet::Packet> packets;
-        std::recursive_mutex _lock;
+        bool started = false;
+        /// Once set the worker isn't changed by its shard until `reset`.
+        std::atomic<bool> readyToWork;
+        std::vector<Slot> window;
+        /// Sequence number of the first slot of the window.
+        uint16_t base = 0;
+        /// Amount of slots from the first one to the last used one.
+        size_t span = 0;
+        /// Amount of frames dropped as late in a row.
+        size_t lateFrames = 0;
+        packet::PacketHistory history;
         size_t packetsAmountThreshold;
 
-        int count();
-        void tryCut();
+        size_t count() const;
+        void release(const Slot &slot);
+        void advance();
+        /// Move the window past all used slots, complete packets are released.
+        void flush();
+        void releaseComplete();
     public:
-        explicit SyncPacketWorker(size_t packetsAmountThreshold = 20);
-        bool addFragment(LogFrame frame);
+        explicit SyncPacketWorker(size_t packetsAmountThreshold = 20, size_t reorderWindow = 32);
+        bool addFragment(LogFrame &frame);
         bool isReadyToWork() const;
         std::vector<packet::Packet> getPackets();
+        /**
+         * Get released packets.
+         *
+         * @return packets which left the reorder window.
+         */
+        const packet::PacketHistory& getHistory() const;
         void reset();
     };
 
+    /**
+     * Multi-threaded frame handler.
+     *
+     * Frames are routed by TA hash to shards, each shard is served by its own thread
+     * and owns its packet workers, so they are changed without locks.
+     * Frames go to shards through bounded SPSC queues, ready workers go
+     * to the single lock-free MPSC output queue shared by all shards.
+     * Frames read from stream are routed by TA found with `findTA` and parsed by shards,
+     * so parsing scales with threads too.
+     * Frames of one TA are handled in the order they are routed.
+     */
     class SyncFrameWorker {
     protected:
-        int threads_cnt;
-        std::recursive_mutex _lock;
-        std::map<uint64_t, SyncPacketWorker> packetsByAddress;
-        std::map <uint64_t, bool> alreadyAddToQueue;
+        /// Frame or lines of frame which shard parses itself.
+        struct Input {
+            LogFrame frame;
+            /// Lines of frame in format of `parse`, empty if `frame` is parsed already.
+            std::vector<std::string> lines;
+            bool oldFileFormat = true;
+        };
+        struct Shard {
+            SPSCQueue<Input> frames;
+            /// Ids of TAs routed to the shard.
+            object::MacTable macs;
+            /// Packet workers indexed by TA's id.
+            std::deque<SyncPacketWorker> packetsByAddress;
+            std::vector<bool> alreadyAddToQueue;
+            /// Amount of frames pushed by producer.
+            size_t routed = 0;
+            /// Amount of frames handled by shard's thread.
+            std::atomic<size_t> handled;
+            std::atomic<bool> sleeping;
+            bool shutdown = false;
+            std::mutex _lock;
+            std::condition_variable _cond_var;
+            std::thread thread;
+
+            explicit Shard(size_t queueCapacity);
+        };
+
+        size_t packetsAmountThreshold;
+        std::vector<std::unique_ptr<Shard>> shards;
+        MPSCQueue<SyncPacketWorker *> ready;
+
+        size_t route(uint64_t TA) const;
+        /**
+         * Push input to shard of TA, wait while its queue is full.
+         *
+         * @param input frame or its lines, it is moved to the shard;
+         * @param TA transmitter address of frame.
+         */
+        void dispatch(Input &&input, uint64_t TA);
+        void shardWork(Shard *shard);
+        void frameHandling(Shard *shard, Input &input);
     public:
-        explicit SyncFrameWorker(int threads_cnt = 1);
-        void frameHandling(std::vector<std::string> lines, std::queue<SyncPacketWorker *> &queue, bool oldFileFormat = true);
+        explicit SyncFrameWorker(int threads_cnt = 1,
+                                 size_t packetsAmountThreshold = 20,
+                                 size_t queueCapacity = 1024);
+        ~SyncFrameWorker();
+        /**
+         * Route frame to its shard, must be called from one thread.
+         *
+         * @param frame frame, it is moved to the shard.
+         */
+        void frameHandle(LogFrame &frame);
+        /**
+         * Wait until all routed frames are handled.
+         */
+        void flush();
+        /**
+         * Pop worker which became ready, must be called from one thread.
+         *
+         * @param worker reference for the result.
+         *
+         * @return false if there are no ready workers.
+         */
+        bool popReady(SyncPacketWorker *&worker);
+        /**
+         * Route frames of stream to shards, they are parsed by shards' threads.
+         * Must be called from the thread which calls `frameHandle`.
+         *
+         * @param in stream of frames;
+         * @param queue queue for workers which became ready;
+         * @param oldFileFormat whether frame takes three lines.
+         *
+         * @return 0 on success, -2 if the last frame is incomplete.
+         */
+        int readFramesFromStream(std::istream &in, std::queue<SyncPacketWorker *> &queue, bool oldFileFormat = true);
         int readFramesFromFile(const std::string &path, std::queue<SyncPacketWorker *> &queue, bool oldFileFormat = true);
         void reset();
     };
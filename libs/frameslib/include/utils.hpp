@@ -66,6 +66,14 @@ namespace frameslib { namespace utils {
      * @return transformed string.
      */
     std::string strToLower(std::string s);
+    /**
+     * Check that string has whitespaces only, like matching of `^\s*$` does.
+     *
+     * @param s source string.
+     *
+     * @return true if `s` is empty or consists of whitespaces.
+     */
+    bool isBlank(const std::string &s);
     bool checkRetransmission(uint64_t a, uint64_t b, uint64_t c);
     /**
      * Get pair of flags which shows existance of header and body in frames from file.
@@ -99,10 +107,16 @@ namespace frameslib { namespace utils {
      */
     template<typename NumericType>
     NumericType fastPow(NumericType base, int exp);
-    template<typename NumericType>
-    NumericType calcMedian(std::vector<NumericType> xs,
-                           std::function<bool(NumericType, NumericType)> cmp,
-                           std::function<NumericType(NumericType)> op = nullptr);
+    /**
+     * Median by selection, values are reordered in place.
+     *
+     * @param xs non-empty buffer with values, its order is changed;
+     * @param cmp strict weak ordering of values.
+     *
+     * @return median of `xs`, the mean of two middle values for even size.
+     */
+    template<typename NumericType, typename Compare = std::less<NumericType>>
+    NumericType calcMedian(std::vector<NumericType> &xs, Compare cmp = Compare());
     template<class T>
     std::vector<T> filter(const std::vector<T>& vec, std::function<bool(T)> predicate);
     template <class T>
@@ -157,14 +171,14 @@ NumericType frameslib::utils::fastPow(NumericType base, int exp) {
 }
 
 
-template<typename NumericType>
-NumericType frameslib::utils::calcMedian(std::vector<NumericType> xs,
-                                         std::function<bool(NumericType, NumericType)> cmp,
-                                         std::function<NumericType(NumericType)> op) {
-    if (op != nullptr)
-        std::transform(xs.cbegin(), xs.cend(), xs.begin(), op);
-    std::sort(xs.begin(), xs.end(), std::move(cmp));
-    return xs.size() % 2 == 0 ? (xs[xs.size()/2-1] + xs[xs.size()/2]) / 2 : xs[xs.size() / 2];
+template<typename NumericType, typename Compare>
+NumericType frameslib::utils::calcMedian(std::vector<NumericType> &xs, Compare cmp) {
+    auto mid = xs.begin() + xs.size() / 2;
+    std::nth_element(xs.begin(), mid, xs.end(), cmp);
+    if (xs.size() % 2 != 0)
+        return *mid;
+    // the lower half holds values not greater than `*mid`, its maximum is the other middle value
+    return (*std::max_element(xs.begin(), mid, cmp) + *mid) / 2;
 }
 template<class T>
 std::vector<T> frameslib::utils::filter(const std::vector<T>& vec,
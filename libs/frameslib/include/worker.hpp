@@ -13,23 +13,80 @@
 #include "frame.hpp"
 #include "classifier.hpp"
 #include "features.hpp"
+#include "slab_pool.hpp"
+#include "mac_table.hpp"
 
 namespace frameslib { namespace frames { namespace worker {
     class Worker {
+    public:
+        typedef SlabPool<object::PacketClassifiedObject>::handle_t handle_t;
+        typedef object::MacTable::id_t id_t;
+        /// Handle of absent object.
+        static const handle_t NONE;
+        /// Raw packets kept by streaming object: the last one may get fragments, the previous one may be retransmission.
+        static const size_t STREAMING_TAIL = 2;
     private:
-        std::unordered_map<uint64_t, std::shared_ptr<object::PacketClassifiedObject>> objects;
-        std::queue<std::shared_ptr<object::PacketClassifiedObject>> queue;
+        /// Objects of all MAC-addresses, addressed by handles.
+        SlabPool<object::PacketClassifiedObject> pool;
+        std::shared_ptr<object::MacTable> macs;
+        /// Handles of objects indexed by MAC-address' id.
+        std::vector<handle_t> objects;
+        /// Handles of objects which are ready for classification.
+        std::queue<handle_t> queue;
         const size_t packetsAmountThreshold;
+        /// New objects stream old packets into features instead of keeping them.
+        bool streaming = false;
     public:
-        explicit Worker(size_t packetsAmountThreshold = 200);
+        explicit Worker(size_t packetsAmountThreshold = 200,
+                        std::shared_ptr<object::MacTable> macs = std::make_shared<object::MacTable>());
         ~Worker();
+        /**
+         * Check whether frame adds packet to object of its TA: only non-broadcast data frames do.
+         *
+         * @param frame frame.
+         *
+         * @return false if frame is ignored by worker.
+         */
+        static bool isPacketFrame(LogFrame &frame);
         void frameHandle(LogFrame &frame);
+        /**
+         * Handle frame whose TA was already interned.
+         *
+         * @param frame frame;
+         * @param id id of frame's TA in the worker's table.
+         */
+        void frameHandle(LogFrame &frame, id_t id);
         int readFramesFromStream(std::istream &in, bool oldFileFormat = true);
         int readFramesFromFile(const std::string &path, bool oldFileFormat = true);
-        const std::unordered_map<uint64_t, std::shared_ptr<object::PacketClassifiedObject>> &getObjects() const;
+        /**
+         * Get handles of all objects.
+         *
+         * @return vector with handles indexed by MAC-address' id, `NONE` for ids without object.
+         */
+        const std::vector<handle_t> &getObjects() const;
+        const std::shared_ptr<object::MacTable> &getMacTable() const;
+        object::PacketClassifiedObject &getObject(handle_t handle);
+        const object::PacketClassifiedObject &getObject(handle_t handle) const;
+        /**
+         * Free object of MAC-address, its id stays in the table.
+         *
+         * @param id id of MAC-address.
+         */
+        void release(id_t id);
+        /**
+         * Switch streaming mode for objects made after the call.
+         *
+         * Streaming object keeps only `STREAMING_TAIL` raw packets after the cut, older ones
+         * are moved into its `StreamingFeatures`, so its memory doesn't grow with the window.
+         * Before the cut it keeps one more packet, the cut leaves only the last two anyway.
+         *
+         * @param enable whether objects stream.
+         */
+        void setStreaming(bool enable);
+        bool isStreaming() const;
         bool isQueueEmpty() const;
         size_t getQueueSize() const;
-        std::shared_ptr<object::PacketClassifiedObject> popFront();
+        handle_t popFront();
         void clear();
     };
 } } }
\ No newline at end of file
@@ -0,0 +1,236 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/batch_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FEATURE_BATCH_X86
+#endif
+
+using namespace std;
+using namespace frameslib;
+
+const size_t features::FeatureBatch::LANES;
+const size_t features::FeatureBatch::FEATURES;
+
+namespace {
+    /// State of moment accumulators of all lanes, field by field.
+    struct MomentColumns {
+        vector<double> n, sum, sumSquares, mean, M2, M3, M4, min, max;
+
+        explicit MomentColumns(size_t lanes) :
+        n(lanes, 0), sum(lanes, 0), sumSquares(lanes, 0), mean(lanes, 0),
+        M2(lanes, 0), M3(lanes, 0), M4(lanes, 0), min(lanes, 0), max(lanes, 0)
+        {}
+
+        features::MomentAccumulator get(size_t lane) const {
+            return {n[lane], sum[lane], sumSquares[lane], mean[lane],
+                    M2[lane], M3[lane], M4[lane], min[lane], max[lane]};
+        }
+    };
+
+    void accumulateScalar(const double *xs, size_t lanes, const uint32_t *lengths,
+                          vector<features::MomentAccumulator> &out) {
+        for (size_t lane = 0; lane < lanes; lane++)
+            for (size_t i = 0; i < lengths[lane]; i++)
+                out[lane].add(xs[i * lanes + lane]);
+    }
+
+#ifdef FEATURE_BATCH_X86
+    __attribute__((target("avx2")))
+    void accumulateAVX2(const double *xs, size_t lanes, const uint32_t *lengths, MomentColumns &out) {
+        const __m256d one = _mm256_set1_pd(1), two = _mm256_set1_pd(2), three = _mm256_set1_pd(3),
+                      four = _mm256_set1_pd(4), six = _mm256_set1_pd(6);
+        for (size_t lane = 0; lane < lanes; lane += 4) {
+            uint32_t length = *max_element(lengths + lane, lengths + lane + 4);
+            if (length == 0) continue;
+            __m256d len = _mm256_set_pd(lengths[lane + 3], lengths[lane + 2], lengths[lane + 1], lengths[lane]);
+            __m256d n = _mm256_setzero_pd(), sum = n, sumSquares = n, mean = n, M2 = n, M3 = n, M4 = n;
+            __m256d min = _mm256_loadu_pd(xs + lane), max = min;
+            for (size_t i = 0; i < length; i++) {
+                __m256d x = _mm256_loadu_pd(xs + i * lanes + lane);
+                __m256d active = _mm256_cmp_pd(n, len, _CMP_LT_OQ);
+                __m256d n1 = n;
+                __m256d nn = _mm256_add_pd(n, one);
+                __m256d delta = _mm256_sub_pd(x, mean);
+                __m256d delta_n = _mm256_div_pd(delta, nn);
+                __m256d delta_n2 = _mm256_mul_pd(delta_n, delta_n);
+                __m256d term = _mm256_mul_pd(_mm256_mul_pd(delta, delta_n), n1);
+                __m256d poly = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(nn, nn), _mm256_mul_pd(three, nn)), three);
+                __m256d dM4 = _mm256_sub_pd(
+                        _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(term, delta_n2), poly),
+                                      _mm256_mul_pd(_mm256_mul_pd(six, delta_n2), M2)),
+                        _mm256_mul_pd(_mm256_mul_pd(four, delta_n), M3));
+                __m256d dM3 = _mm256_sub_pd(
+                        _mm256_mul_pd(_mm256_mul_pd(term, delta_n), _mm256_sub_pd(nn, two)),
+                        _mm256_mul_pd(_mm256_mul_pd(three, delta_n), M2));
+                n = _mm256_blendv_pd(n, nn, active);
+                sum = _mm256_blendv_pd(sum, _mm256_add_pd(sum, x), active);
+                sumSquares = _mm256_blendv_pd(sumSquares, _mm256_add_pd(sumSquares, _mm256_mul_pd(x, x)), active);
+                mean = _mm256_blendv_pd(mean, _mm256_add_pd(mean, delta_n), active);
+                M4 = _mm256_blendv_pd(M4, _mm256_add_pd(M4, dM4), active);
+                M3 = _mm256_blendv_pd(M3, _mm256_add_pd(M3, dM3), active);
+                M2 = _mm256_blendv_pd(M2, _mm256_add_pd(M2, term), active);
+                // operands in this order keep the current extreme value on ties, as std::min/max do
+                min = _mm256_blendv_pd(min, _mm256_min_pd(x, min), active);
+                max = _mm256_blendv_pd(max, _mm256_max_pd(x, max), active);
+            }
+            _mm256_storeu_pd(&out.n[lane], n);
+            _mm256_storeu_pd(&out.sum[lane], sum);
+            _mm256_storeu_pd(&out.sumSquares[lane], sumSquares);
+            _mm256_storeu_pd(&out.mean[lane], mean);
+            _mm256_storeu_pd(&out.M2[lane], M2);
+            _mm256_storeu_pd(&out.M3[lane], M3);
+            _mm256_storeu_pd(&out.M4[lane], M4);
+            _mm256_storeu_pd(&out.min[lane], min);
+            _mm256_storeu_pd(&out.max[lane], max);
+        }
+    }
+
+    /// SSE2 has no blendv, lanes are selected by mask.
+    __attribute__((target("sse2")))
+    inline __m128d select(__m128d mask, __m128d a, __m128d b) {
+        return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+    }
+
+    __attribute__((target("sse2")))
+    void accumulateSSE2(const double *xs, size_t lanes, const uint32_t *lengths, MomentColumns &out) {
+        const __m128d one = _mm_set1_pd(1), two = _mm_set1_pd(2), three = _mm_set1_pd(3),
+                      four = _mm_set1_pd(4), six = _mm_set1_pd(6);
+        for (size_t lane = 0; lane < lanes; lane += 2) {
+            uint32_t length = std::max(lengths[lane], lengths[lane + 1]);
+            if (length == 0) continue;
+            __m128d len = _mm_set_pd(lengths[lane + 1], lengths[lane]);
+            __m128d n = _mm_setzero_pd(), sum = n, sumSquares = n, mean = n, M2 = n, M3 = n, M4 = n;
+            __m128d min = _mm_loadu_pd(xs + lane), max = min;
+            for (size_t i = 0; i < length; i++) {
+                __m128d x = _mm_loadu_pd(xs + i * lanes + lane);
+                __m128d active = _mm_cmplt_pd(n, len);
+                __m128d n1 = n;
+                __m128d nn = _mm_add_pd(n, one);
+                __m128d delta = _mm_sub_pd(x, mean);
+                __m128d delta_n = _mm_div_pd(delta, nn);
+                __m128d delta_n2 = _mm_mul_pd(delta_n, delta_n);
+                __m128d term = _mm_mul_pd(_mm_mul_pd(delta, delta_n), n1);
+                __m128d poly = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(nn, nn), _mm_mul_pd(three, nn)), three);
+                __m128d dM4 = _mm_sub_pd(
+                        _mm_add_pd(_mm_mul_pd(_mm_mul_pd(term, delta_n2), poly),
+                                   _mm_mul_pd(_mm_mul_pd(six, delta_n2), M2)),
+                        _mm_mul_pd(_mm_mul_pd(four, delta_n), M3));
+                __m128d dM3 = _mm_sub_pd(
+                        _mm_mul_pd(_mm_mul_pd(term, delta_n), _mm_sub_pd(nn, two)),
+                        _mm_mul_pd(_mm_mul_pd(three, delta_n), M2));
+                n = select(active, n, nn);
+                sum = select(active, sum, _mm_add_pd(sum, x));
+                sumSquares = select(active, sumSquares, _mm_add_pd(sumSquares, _mm_mul_pd(x, x)));
+                mean = select(active, mean, _mm_add_pd(mean, delta_n));
+                M4 = select(active, M4, _mm_add_pd(M4, dM4));
+                M3 = select(active, M3, _mm_add_pd(M3, dM3));
+                M2 = select(active, M2, _mm_add_pd(M2, term));
+                min = select(active, min, _mm_min_pd(x, min));
+                max = select(active, max, _mm_max_pd(x, max));
+            }
+            _mm_storeu_pd(&out.n[lane], n);
+            _mm_storeu_pd(&out.sum[lane], sum);
+            _mm_storeu_pd(&out.sumSquares[lane], sumSquares);
+            _mm_storeu_pd(&out.mean[lane], mean);
+            _mm_storeu_pd(&out.M2[lane], M2);
+            _mm_storeu_pd(&out.M3[lane], M3);
+            _mm_storeu_pd(&out.M4[lane], M4);
+            _mm_storeu_pd(&out.min[lane], min);
+            _mm_storeu_pd(&out.max[lane], max);
+        }
+    }
+#endif
+}
+
+features::FeatureBatch::FeatureBatch(const vector<const packet::PacketHistory *> &histories) :
+devices(histories.size())
+{
+    lanes = (devices + LANES - 1) / LANES * LANES;
+    lengths.assign(lanes, 0);
+    for (size_t d = 0; d < devices; d++) {
+        lengths[d] = uint32_t(histories[d]->size());
+        maxLength = std::max(maxLength, histories[d]->size());
+    }
+    sizes.assign(maxLength * lanes, 0);
+    intervals.assign(maxLength * lanes, 0);
+    for (size_t d = 0; d < devices; d++) {
+        const vector<uint32_t> &sizes_v = histories[d]->getSizes();
+        const vector<double> &offsets = histories[d]->getOffsets();
+        for (size_t i = 0; i < lengths[d]; i++) {
+            sizes[i * lanes + d] = sizes_v[i];
+            intervals[i * lanes + d] = i == 0 ? histories[d]->getArrivalTimes()[0] : offsets[i] - offsets[i - 1];
+        }
+    }
+}
+
+size_t features::FeatureBatch::size() const {
+    return devices;
+}
+
+features::FeatureBatch::Kernel features::FeatureBatch::detectKernel() {
+#ifdef FEATURE_BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SSE2;
+#endif
+    return Scalar;
+}
+
+void features::FeatureBatch::calcFeatures(double *out, size_t stride, Kernel kernel) const {
+    writeFeatures(out, stride, kernel);
+}
+
+void features::FeatureBatch::calcFeatures(float *out, size_t stride, Kernel kernel) const {
+    writeFeatures(out, stride, kernel);
+}
+
+template <typename T>
+void features::FeatureBatch::writeFeatures(T *out, size_t stride, Kernel kernel) const {
+    if (devices == 0) return;
+    // moments of all devices
+    vector<MomentAccumulator> sizeMoments(lanes), intervalMoments(lanes);
+    auto accumulate = [&](const vector<double> &xs, vector<MomentAccumulator> &accs) {
+#ifdef FEATURE_BATCH_X86
+        if (kernel != Scalar) {
+            MomentColumns columns(lanes);
+            if (kernel == AVX2)
+                accumulateAVX2(xs.data(), lanes, lengths.data(), columns);
+            else
+                accumulateSSE2(xs.data(), lanes, lengths.data(), columns);
+            for (size_t lane = 0; lane < lanes; lane++)
+                accs[lane] = columns.get(lane);
+            return;
+        }
+#endif
+        accumulateScalar(xs.data(), lanes, lengths.data(), accs);
+    };
+    accumulate(sizes, sizeMoments);
+    accumulate(intervals, intervalMoments);
+    // median, MAD and pivot of every device
+    vector<uint32_t> sizes_v;
+    vector<double> scratch, tmp;
+    for (size_t d = 0; d < devices; d++) {
+        T *row = out + d * stride;
+        sizes_v.resize(lengths[d]);
+        for (size_t i = 0; i < lengths[d]; i++)
+            sizes_v[i] = uint32_t(sizes[i * lanes + d]);
+        tmp = UniqueFeatures(sizes_v).toVector();
+        row = copy(tmp.begin(), tmp.end(), row);
+        for (const auto &column : {make_pair(&sizes, &sizeMoments), make_pair(&intervals, &intervalMoments)}) {
+            scratch.resize(lengths[d]);
+            for (size_t i = 0; i < lengths[d]; i++)
+                scratch[i] = (*column.first)[i * lanes + d];
+            double median = utils::calcMedian(scratch);
+            for (double &x : scratch)
+                x = std::fabs(x - median);
+            tmp = StandardFeatures((*column.second)[d], median, utils::calcMedian(scratch)).toVector();
+            row = copy(tmp.begin(), tmp.end(), row);
+        }
+    }
+}
@@ -7,37 +7,148 @@
 using namespace std;
 using namespace frameslib;
 
-features::StandardFeatures::StandardFeatures(vector<double> xs) {
-    auto n = double(xs.size());
+features::MomentAccumulator::MomentAccumulator(double n, double sum, double sumSquares, double mean,
+                                               double M2, double M3, double M4, double min, double max) :
+n(n),
+sum(sum),
+sumSquares(sumSquares),
+runningMean(mean),
+M2(M2),
+M3(M3),
+M4(M4),
+min(min),
+max(max)
+{}
+
+void features::MomentAccumulator::add(double x) {
+    if (n == 0)
+        min = max = x;
+    else {
+        min = std::min(min, x);
+        max = std::max(max, x);
+    }
+    double n1 = n;
+    n += 1;
+    sum += x;
+    sumSquares += x * x;
+    double delta = x - runningMean;
+    double delta_n = delta / n;
+    double delta_n2 = delta_n * delta_n;
+    double term = delta * delta_n * n1;
+    runningMean += delta_n;
+    M4 += term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * M2 - 4 * delta_n * M3;
+    M3 += term * delta_n * (n - 2) - 3 * delta_n * M2;
+    M2 += term;
+}
+
+void features::MomentAccumulator::merge(const MomentAccumulator &other) {
+    if (other.n == 0) return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    double na = n, nb = other.n, nn = na + nb;
+    double delta = other.runningMean - runningMean;
+    double delta2 = delta * delta;
+    double M2_v = M2 + other.M2 + delta2 * na * nb / nn;
+    double M3_v = M3 + other.M3 + delta2 * delta * na * nb * (na - nb) / (nn * nn)
+                  + 3 * delta * (na * other.M2 - nb * M2) / nn;
+    double M4_v = M4 + other.M4 + delta2 * delta2 * na * nb * (na * na - na * nb + nb * nb) / (nn * nn * nn)
+                  + 6 * delta2 * (na * na * other.M2 + nb * nb * M2) / (nn * nn)
+                  + 4 * delta * (na * other.M3 - nb * M3) / nn;
+    runningMean += delta * nb / nn;
+    M2 = M2_v;
+    M3 = M3_v;
+    M4 = M4_v;
+    n = nn;
+    sum += other.sum;
+    sumSquares += other.sumSquares;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+size_t features::MomentAccumulator::getCount() const {
+    return size_t(n);
+}
+
+double features::MomentAccumulator::getMin() const {
+    return min;
+}
+
+double features::MomentAccumulator::getMax() const {
+    return max;
+}
+
+double features::MomentAccumulator::getMean() const {
+    return sum / n;
+}
+
+double features::MomentAccumulator::getMSquare() const {
+    return sumSquares / n;
+}
+
+double features::MomentAccumulator::getVariance() const {
+    return M2 / n;
+}
+
+double features::MomentAccumulator::getThirdMoment() const {
+    return M3 / n;
+}
+
+double features::MomentAccumulator::getFourthMoment() const {
+    return M4 / n;
+}
+
+namespace {
+    /**
+     * Make features of values in the buffer.
+     *
+     * @param scratch non-empty buffer with values, it is overwritten.
+     *
+     * @return features of values.
+     */
+    features::StandardFeatures calcStandardFeatures(vector<double> &scratch) {
+        features::MomentAccumulator acc;
+        for (double x : scratch)
+            acc.add(x);
+        // median
+        double median = utils::calcMedian(scratch);
+        // medianAD
+        for (double &x : scratch)
+            x = std::fabs(x - median);
+        double medianAD = utils::calcMedian(scratch);
+        return {acc, median, medianAD};
+    }
+}
+
+features::StandardFeatures::StandardFeatures(const vector<double> &xs) {
+    vector<double> scratch(xs);
+    *this = calcStandardFeatures(scratch);
+}
+
+features::StandardFeatures::StandardFeatures(const MomentAccumulator &acc, double median, double medianAD) :
+median(median),
+medianAD(medianAD)
+{
     // min, max
-    min = *std::min_element(xs.begin(), xs.end());
-    max = *std::max_element(xs.begin(), xs.end());
-    // median, medianAD
-    median = utils::calcMedian<double>(xs, [](double a, double b) { return a < b; });
-    medianAD = utils::calcMedian<double>(xs,
-                                         [](double a, double b) { return a < b; },
-                                         [m = median](double a) { return std::fabs(a - m); });
+    min = acc.getMin();
+    max = acc.getMax();
     // mean
-    mean = std::accumulate(xs.begin(), xs.end(), 0.0) / n;
-    auto m_i = [m = mean, n](vector<double> xs, int i) {
-        return std::accumulate(xs.begin(), xs.end(), 0.0, [m, i](double acc, double x) {
-            return acc + utils::fastPow(x - m, i);
-        }) / n;
-    };
+    mean = acc.getMean();
     // variance
-    variance = m_i(xs, 2);
+    variance = acc.getVariance();
     // standard deviation
     standardDeviation = std::sqrt(variance);
     // m_square
-    m_square = std::accumulate(xs.begin(), xs.end(), 0.0, [](double acc, double x) { return acc + x * x; }) / n;
+    m_square = acc.getMSquare();
     // root-mean-square
     rootMeanSquare = std::sqrt(m_square);
     // p_skewness
     p_skewness = 3.0 * (mean - median) / standardDeviation;
     // kurtosis
-    kurtosys = m_i(xs, 4) / utils::fastPow(variance, 2);
+    kurtosys = acc.getFourthMoment() / utils::fastPow(variance, 2);
     // skewness
-    skewness = m_i(xs, 3) / utils::fastPow(standardDeviation, 3);
+    skewness = acc.getThirdMoment() / utils::fastPow(standardDeviation, 3);
 }
 
 string features::StandardFeatures::toString() const {
@@ -106,25 +217,38 @@ double features::StandardFeatures::getMedianAD() const {
     return medianAD;
 }
 
-features::UniqueFeatures::UniqueFeatures(const vector<packet::Packet>& packets) {
-    // find pivot
-    map<uint64_t, uint16_t> sizeAmounts;
-    uint64_t totalSize = 0, MTU = 0;
-    for (const auto &packet: packets) {
-        uint64_t size = packet.getSize();
-        sizeAmounts[size]++;
+features::UniqueFeatures::UniqueFeatures(const vector<packet::Packet>& packets) :
+UniqueFeatures(packet::PacketHistory(packets))
+{}
+
+features::UniqueFeatures::UniqueFeatures(const packet::PacketHistory& history) :
+UniqueFeatures(history.getSizes())
+{}
+
+features::UniqueFeatures::UniqueFeatures(const vector<uint32_t>& sizes) {
+    // equal sizes are counted as runs of sorted copy
+    vector<uint32_t> sorted(sizes);
+    sort(sorted.begin(), sorted.end());
+    uint64_t totalSize = 0, MTU = sorted.empty() ? 0 : sorted.back();
+    for (uint64_t size : sizes)
         totalSize += size;
-        MTU = max(MTU, size);
-    }
+    // find pivot
     pivotSize = double(MTU);
-    for (const auto &p : packets)
-        if (p.getSize() != MTU) {
-            pivotSize = double(p.getSize());
+    for (uint64_t size : sizes)
+        if (size != MTU) {
+            pivotSize = double(size);
             break;
         }
-    for (const auto &p : sizeAmounts)
-        if (p.first != MTU && p.second > sizeAmounts[uint64_t(pivotSize)])
-            pivotSize = double(p.first);
+    auto pivotRange = equal_range(sorted.begin(), sorted.end(), uint32_t(pivotSize));
+    size_t pivotAmount = pivotRange.second - pivotRange.first;
+    for (auto it = sorted.begin(); it != sorted.end();) {
+        auto next = upper_bound(it, sorted.end(), *it);
+        if (*it != MTU && size_t(next - it) > pivotAmount) {
+            pivotSize = double(*it);
+            pivotAmount = next - it;
+        }
+        it = next;
+    }
     // pivot size / MTU size
     PM = pivotSize / double(MTU);
     // pivot size / total sample size
@@ -154,23 +278,24 @@ double features::UniqueFeatures::getPT() const {
     return PT;
 }
 
-vector<double> features::excludeFeaturesFromPacketsWithSkips(const vector<packet::Packet> &packets,
+vector<double> features::excludeFeaturesFromPacketsWithSkips(const packet::PacketHistory &history,
                                                              const unordered_set<size_t> &skips) {
     vector<double> tmp, curFeatures;
-    tmp = UniqueFeatures(packets).toVector();
+    tmp = UniqueFeatures(history).toVector();
     curFeatures.insert(curFeatures.end(), tmp.begin(), tmp.end());
-    tmp.clear();
-    transform(packets.begin(), packets.end(), back_inserter(tmp), [](auto p) { return p.getSize(); });
-    tmp = StandardFeatures(tmp).toVector();
+    // one buffer for sizes and intervals
+    vector<double> scratch;
+    const vector<uint32_t> &sizes = history.getSizes();
+    scratch.assign(sizes.begin(), sizes.end());
+    tmp = calcStandardFeatures(scratch).toVector();
     curFeatures.insert(curFeatures.end(), tmp.begin(), tmp.end());
-    tmp.clear();
-    transform(packets.begin(), packets.end(), back_inserter(tmp), [](auto p) { return p.getOffset(); });
-    for (uint32_t i = tmp.size() - 1; i > 0; i--)
-        tmp[i] -= tmp[i - 1];
-    tmp[0] = packets[0].getArrivalTime();
-    tmp = StandardFeatures(tmp).toVector();
+    const vector<double> &offsets = history.getOffsets();
+    scratch.resize(offsets.size());
+    for (size_t i = offsets.size() - 1; i > 0; i--)
+        scratch[i] = offsets[i] - offsets[i - 1];
+    scratch[0] = history.getArrivalTimes()[0];
+    tmp = calcStandardFeatures(scratch).toVector();
     curFeatures.insert(curFeatures.end(), tmp.begin(), tmp.end());
-    tmp.clear();
     tmp = curFeatures;
     curFeatures.clear();
     for (size_t i = 0; i < tmp.size(); i++)
@@ -178,6 +303,15 @@ vector<double> features::excludeFeaturesFromPacketsWithSkips(const vector<packet
     return curFeatures;
 }
 
+vector<double> features::excludeFeaturesFromPacketsWithSkips(const vector<packet::Packet> &packets,
+                                                             const unordered_set<size_t> &skips) {
+    return excludeFeaturesFromPacketsWithSkips(packet::PacketHistory(packets), skips);
+}
+
+vector<double> features::excludeFeaturesFromPackets(const packet::PacketHistory &history) {
+    return excludeFeaturesFromPacketsWithSkips(history);
+}
+
 vector<double> features::excludeFeaturesFromPackets(const vector<packet::Packet> &packets) {
     return excludeFeaturesFromPacketsWithSkips(packets);
 }
\ No newline at end of file
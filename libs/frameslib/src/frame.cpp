@@ -3,6 +3,7 @@
 //
 
 #include "../include/frame.hpp"
+#include "../include/utils.hpp"
 
 using namespace std;
 
@@ -255,6 +256,46 @@ frameslib::frames::LogFrame frameslib::frames::parse(const vector<string> &lines
     return {ind_v, Offset_v, BW_v, MCS_v, Size_v, Frame_v, info_v, FCS_v, Type_v, SSID_v, TA_v, RA_v, moreFrags, seqNum, fragNum};
 }
 
+namespace {
+    /**
+     * Read MAC-address `h:h:h:h:h:h` of hexadecimal groups.
+     *
+     * @param pos beginning of address;
+     * @param end end of line;
+     * @param mac result, groups are concatenated like `parse` does.
+     *
+     * @return false if there is no address at `pos`.
+     */
+    bool readMAC(const char *pos, const char *end, uint64_t &mac) {
+        mac = 0;
+        for (int group = 0; group < 6; group++) {
+            if (group > 0) {
+                if (pos == end || *pos != ':') return false;
+                ++pos;
+            }
+            const char *begin = pos;
+            for (; pos != end && isxdigit(static_cast<unsigned char>(*pos)); ++pos) {
+                int digit = isdigit(static_cast<unsigned char>(*pos)) ? *pos - '0' : tolower(*pos) - 'a' + 10;
+                mac = mac * 16 + uint64_t(digit);
+            }
+            if (pos == begin) return false;
+        }
+        return true;
+    }
+}
+
+tl::optional<uint64_t> frameslib::frames::findTA(const string &info) {
+    // the first "TA" followed by the nearest '=' with address, like lazy "TA.*?=" of `parse`
+    const char *end = info.data() + info.size();
+    for (size_t ta = info.find("TA"); ta != string::npos; ta = info.find("TA", ta + 1))
+        for (size_t eq = info.find('=', ta + 2); eq != string::npos; eq = info.find('=', eq + 1)) {
+            uint64_t mac;
+            if (readMAC(info.data() + eq + 1, end, mac))
+                return mac;
+        }
+    return tl::nullopt;
+}
+
 int frameslib::frames::readFromFile(const string &path,
                                      vector<LogFrame> &to,
                                      bool hasHeader,
@@ -272,8 +313,7 @@ int frameslib::frames::readFromFile(const string &path,
         string line;
         while (getline(in, line, '\n')) {
             // skip empty string
-            smatch match;
-            if (regex_match(line, match, regex("^\\s*$"))) {
+            if (utils::isBlank(line)) {
                 continue;
             }
 
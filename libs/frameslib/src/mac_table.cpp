@@ -0,0 +1,42 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/mac_table.hpp"
+
+using namespace std;
+using namespace frameslib;
+
+const object::MacTable::id_t object::MacTable::NONE = UINT32_MAX;
+
+object::MacTable::id_t object::MacTable::intern(MAC_t mac) {
+    auto it = ids.find(mac);
+    if (it != ids.end())
+        return it->second;
+    id_t id = id_t(macs.size());
+    macs.emplace_back(mac);
+    ids.emplace(mac, id);
+    return id;
+}
+
+object::MacTable::id_t object::MacTable::find(MAC_t mac) const {
+    auto it = ids.find(mac);
+    return it != ids.end() ? it->second : NONE;
+}
+
+object::MAC_t object::MacTable::getMAC(id_t id) const {
+    return macs[id];
+}
+
+size_t object::MacTable::size() const {
+    return ids.size();
+}
+
+size_t object::MacTable::range() const {
+    return macs.size();
+}
+
+void object::MacTable::clear() {
+    ids.clear();
+    macs.clear();
+}
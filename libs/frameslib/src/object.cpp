@@ -69,66 +69,266 @@ void object::SimpleClassifiedObject::setFeature(SimpleFeature ftr) {
     feature = ftr;
 }
 
+const uint32_t object::PacketCollection::TOMBSTONE = UINT32_MAX;
+
 object::PacketCollection::PacketCollection(size_t packetsAmountThreshold) :
-PacketCollection()
+cap(max(packetsAmountThreshold, size_t(3))),
+storage(new uint8_t[storageSize(cap)])
 {
-    packets.reserve(packetsAmountThreshold);
+    bind();
+    fill(gaps, gaps + cap, TOMBSTONE);
 }
 
 object::PacketCollection::PacketCollection(PacketCollection *collection) :
-packets(vector<packet::Packet>(collection->packets))
+PacketCollection(*collection)
 {}
 
+object::PacketCollection::PacketCollection(const PacketCollection& collection) :
+cap(collection.cap),
+storage(new uint8_t[storageSize(cap)]),
+head(collection.head),
+used(collection.used),
+alive(collection.alive)
+{
+    bind();
+    copy(collection.storage.get(), collection.storage.get() + storageSize(cap), storage.get());
+}
+
 object::PacketCollection::PacketCollection(PacketCollection&& collection) noexcept :
-packets(std::move(collection.packets)) 
+cap(collection.cap),
+storage(std::move(collection.storage)),
+head(collection.head),
+used(collection.used),
+alive(collection.alive)
 {
-    collection.packets.clear();
+    bind();
+    collection.cap = collection.head = collection.used = collection.alive = 0;
+    collection.bind();
 }
 
 object::PacketCollection::~PacketCollection() {
-    packets.clear();
+    storage.reset();
 }
 
 object::PacketCollection& object::PacketCollection::operator=(const PacketCollection& collection) {
-    this->packets = vector<packet::Packet>(collection.packets);
+    if (this == &collection) return *this;
+    if (this->cap != collection.cap) {
+        this->cap = collection.cap;
+        this->storage.reset(new uint8_t[storageSize(cap)]);
+        bind();
+    }
+    copy(collection.storage.get(), collection.storage.get() + storageSize(cap), storage.get());
+    this->head = collection.head;
+    this->used = collection.used;
+    this->alive = collection.alive;
     return *this;
 }
 
 object::PacketCollection& object::PacketCollection::operator=(PacketCollection&& collection) noexcept {
-    this->packets = std::move(collection.packets);
-    collection.packets.clear();
+    this->cap = collection.cap;
+    this->storage = std::move(collection.storage);
+    this->head = collection.head;
+    this->used = collection.used;
+    this->alive = collection.alive;
+    bind();
+    collection.cap = collection.head = collection.used = collection.alive = 0;
+    collection.bind();
     return *this;
 }
 
-bool object::PacketCollection::empty() {
-    return packets.empty();
+size_t object::PacketCollection::storageSize(size_t capacity) {
+    return capacity * (2 * sizeof(double) + 2 * sizeof(uint32_t) + 2 * sizeof(uint16_t));
+}
+
+void object::PacketCollection::bind() {
+    // Columns go from the widest type to the narrowest one, so each of them is aligned
+    uint8_t *ptr = storage.get();
+    offsets = reinterpret_cast<double *>(ptr);
+    arrivalTimes = offsets + cap;
+    sizes = reinterpret_cast<uint32_t *>(arrivalTimes + cap);
+    gaps = sizes + cap;
+    seqNums = reinterpret_cast<uint16_t *>(gaps + cap);
+    fragsAmounts = seqNums + cap;
+}
+
+size_t object::PacketCollection::slot(size_t pos) const {
+    pos += head;
+    return pos < cap ? pos : pos - cap;
+}
+
+size_t object::PacketCollection::locate(size_t id, size_t &next) const {
+    const size_t NONE = SIZE_MAX;
+    // Without tombstones position equals index
+    if (alive == used) {
+        next = id + 1 < used ? id + 1 : NONE;
+        return id;
+    }
+    size_t pos;
+    next = NONE;
+    if (id >= alive / 2) {
+        // Go from the tail jumping over tombstones
+        pos = used - 1;
+        for (size_t i = alive - 1; i > id; i--) {
+            next = pos;
+            pos -= gaps[slot(pos)] + 1;
+        }
+        return pos;
+    }
+    // Go from the head skipping tombstones
+    pos = 0;
+    for (size_t i = 0; i < id; i++)
+        for (pos++; gaps[slot(pos)] == TOMBSTONE; pos++);
+    next = pos + 1;
+    for (; gaps[slot(next)] == TOMBSTONE; next++);
+    return pos;
+}
+
+size_t object::PacketCollection::physical(size_t id) const {
+    size_t next;
+    return slot(locate(id, next));
+}
+
+void object::PacketCollection::compact() {
+    auto rotateColumn = [this](auto *column) {
+        rotate(column, column + head, column + cap);
+    };
+    rotateColumn(seqNums);
+    rotateColumn(sizes);
+    rotateColumn(offsets);
+    rotateColumn(arrivalTimes);
+    rotateColumn(fragsAmounts);
+    rotateColumn(gaps);
+    head = 0;
+    size_t w = 0;
+    for (size_t r = 0; r < used; r++) {
+        if (gaps[r] == TOMBSTONE) continue;
+        if (r != w) {
+            seqNums[w] = seqNums[r];
+            sizes[w] = sizes[r];
+            offsets[w] = offsets[r];
+            arrivalTimes[w] = arrivalTimes[r];
+            fragsAmounts[w] = fragsAmounts[r];
+            gaps[r] = TOMBSTONE;
+        }
+        gaps[w++] = 0;
+    }
+    used = alive;
+}
+
+bool object::PacketCollection::empty() const {
+    return alive == 0;
 }
 
-void object::PacketCollection::addPacket(packet::Packet &pack) {
-    packets.emplace_back(pack);
+size_t object::PacketCollection::size() const {
+    return alive;
+}
+
+size_t object::PacketCollection::capacity() const {
+    return cap;
+}
+
+void object::PacketCollection::addPacket(const packet::Packet &pack) {
+    if (used == cap) {
+        if (alive < used)
+            compact();
+        else
+            removeFirstPackets(1);
+    }
+    size_t s = slot(used++);
+    seqNums[s] = uint16_t(pack.getSeqNum());
+    sizes[s] = uint32_t(pack.getSize());
+    offsets[s] = pack.getOffset();
+    arrivalTimes[s] = pack.getArrivalTime();
+    fragsAmounts[s] = uint16_t(pack.getFragSize());
+    gaps[s] = 0;
+    alive++;
+}
+
+void object::PacketCollection::addFragment(frames::LogFrame *frame) {
+    if (alive == 0) return;
+    size_t s = slot(used - 1);
+    if (seqNums[s] != frame->getSeqNum() || uint64_t(fragsAmounts[s]) - 1 == frame->getFragNum())
+        return;
+    fragsAmounts[s]++;
+    sizes[s] += frame->getSize();
+    offsets[s] = max(offsets[s], frame->getOffset());
 }
 
 void object::PacketCollection::removeByIndex(size_t id) {
-    packets.erase(packets.begin() + id);
+    if (id >= alive) return;
+    if (id == 0) {
+        removeFirstPackets(1);
+        return;
+    }
+    size_t next, pos = locate(id, next);
+    size_t s = slot(pos);
+    if (next == SIZE_MAX)
+        // The last packet, move the tail to the previous alive one
+        used = pos - gaps[s];
+    else
+        gaps[slot(next)] += gaps[s] + 1;
+    gaps[s] = TOMBSTONE;
+    alive--;
 }
 
 void object::PacketCollection::removeFirstPackets(size_t cnt) {
-    packets.erase(packets.begin(), packets.begin() + cnt);
+    for (cnt = min(cnt, alive); cnt > 0; cnt--) {
+        gaps[head] = TOMBSTONE;
+        head = slot(1);
+        used--;
+        alive--;
+        for (; used > 0 && gaps[head] == TOMBSTONE; used--)
+            head = slot(1);
+    }
+    if (used > 0)
+        gaps[head] = 0;
+    else
+        head = 0;
+}
+
+uint64_t object::PacketCollection::getSeqNum(size_t id) const {
+    return seqNums[physical(id)];
+}
+
+uint64_t object::PacketCollection::getSize(size_t id) const {
+    return sizes[physical(id)];
+}
+
+double object::PacketCollection::getOffset(size_t id) const {
+    return offsets[physical(id)];
+}
+
+void object::PacketCollection::setArrivalTime(size_t id, double time) {
+    arrivalTimes[physical(id)] = time;
+}
+
+packet::PacketHistory object::PacketCollection::getHistory() const {
+    packet::PacketHistory res;
+    res.reserve(alive);
+    for (size_t pos = 0; pos < used; pos++) {
+        size_t s = slot(pos);
+        if (gaps[s] != TOMBSTONE)
+            res.addPacket(seqNums[s], sizes[s], offsets[s], arrivalTimes[s], fragsAmounts[s]);
+    }
+    return res;
 }
 
-const vector<packet::Packet>& object::PacketCollection::getPackets() const {
-    return packets;
+vector<packet::Packet> object::PacketCollection::getPackets() const {
+    return getHistory().getPackets();
 }
 
-packet::Packet& object::PacketCollection::getPacket(size_t id) {
-    return packets[id];
+packet::Packet object::PacketCollection::getPacket(size_t id) const {
+    size_t s = physical(id);
+    return packet::Packet(seqNums[s], sizes[s], offsets[s], arrivalTimes[s], fragsAmounts[s]);
 }
 
-object::PacketClassifiedObject::PacketClassifiedObject(MAC_t mac, DeviceType type, size_t packetsAmountThreshold) :
+object::PacketClassifiedObject::PacketClassifiedObject(MAC_t mac, DeviceType type, size_t packetsAmountThreshold,
+                                                       bool streaming) :
 mac(mac),
-type(type)
+type(type),
+packets(packetsAmountThreshold),
+stream(streaming ? make_unique<features::StreamingFeatures>() : nullptr)
 {
-    this->packets = make_unique<PacketCollection>(packetsAmountThreshold);
 }
 
 object::PacketClassifiedObject::PacketClassifiedObject(PacketClassifiedObject&& obj) noexcept :
@@ -137,24 +337,25 @@ type(obj.type),
 ready(obj.ready),
 needCut(obj.needCut),
 amountCutPackets(obj.amountCutPackets),
-packets(std::move(obj.packets))
-{
-    obj.packets = nullptr;
-}
+amountAppended(obj.amountAppended),
+amountRemoved(obj.amountRemoved),
+packets(std::move(obj.packets)),
+stream(std::move(obj.stream))
+{}
 
 object::PacketClassifiedObject::PacketClassifiedObject(const object::PacketClassifiedObject& obj) noexcept : 
 mac(obj.mac),
 type(obj.type),
 ready(obj.ready),
 needCut(obj.needCut),
-amountCutPackets(obj.amountCutPackets) 
-{
-    packets = make_unique<PacketCollection>(new PacketCollection(obj.packets.get()));
-}
+amountCutPackets(obj.amountCutPackets),
+amountAppended(obj.amountAppended),
+amountRemoved(obj.amountRemoved),
+packets(obj.packets),
+stream(obj.stream ? make_unique<features::StreamingFeatures>(*obj.stream) : nullptr)
+{}
 
-object::PacketClassifiedObject::~PacketClassifiedObject() {
-    packets.reset(nullptr);
-}
+object::PacketClassifiedObject::~PacketClassifiedObject() = default;
 
 object::PacketClassifiedObject& object::PacketClassifiedObject::operator=(PacketClassifiedObject&& obj) noexcept {
     this->mac = obj.mac;
@@ -162,8 +363,10 @@ object::PacketClassifiedObject& object::PacketClassifiedObject::operator=(Packet
     this->ready = obj.ready;
     this->needCut = obj.needCut;
     this->amountCutPackets = obj.amountCutPackets;
+    this->amountAppended = obj.amountAppended;
+    this->amountRemoved = obj.amountRemoved;
     this->packets = std::move(obj.packets);
-    obj.packets = nullptr;
+    this->stream = std::move(obj.stream);
     return *this;
 }
 
@@ -173,7 +376,10 @@ object::PacketClassifiedObject& object::PacketClassifiedObject::operator=(const
     this->ready = obj.ready;
     this->needCut = obj.needCut;
     this->amountCutPackets = obj.amountCutPackets;
-    this->packets = make_unique<PacketCollection>(obj.packets.get());
+    this->amountAppended = obj.amountAppended;
+    this->amountRemoved = obj.amountRemoved;
+    this->packets = obj.packets;
+    this->stream = obj.stream ? make_unique<features::StreamingFeatures>(*obj.stream) : nullptr;
     return *this;
 }
 
@@ -193,7 +399,19 @@ string object::PacketClassifiedObject::getDefinition() const {
 }
 
 bool object::PacketClassifiedObject::isPacketsEmpty() const {
-    return packets->empty();
+    return packets.empty();
+}
+
+size_t object::PacketClassifiedObject::getWindowSize() const {
+    return (stream ? stream->size() : 0) + packets.size();
+}
+
+const features::StreamingFeatures *object::PacketClassifiedObject::getStream() const {
+    return stream.get();
+}
+
+size_t object::PacketClassifiedObject::getPacketsAmount() const {
+    return packets.size();
 }
 
 bool object::PacketClassifiedObject::isReady() const {
@@ -204,12 +422,28 @@ bool object::PacketClassifiedObject::isNeedCut() const {
     return needCut;
 }
 
+uint32_t object::PacketClassifiedObject::getAmountCutPackets() const {
+    return amountCutPackets;
+}
+
+uint32_t object::PacketClassifiedObject::getAmountAppended() const {
+    return amountAppended;
+}
+
+uint32_t object::PacketClassifiedObject::getAmountRemoved() const {
+    return amountRemoved;
+}
+
 vector<packet::Packet> object::PacketClassifiedObject::getPackets() const {
-    return packets->getPackets();
+    return packets.getPackets();
+}
+
+packet::PacketHistory object::PacketClassifiedObject::getHistory() const {
+    return packets.getHistory();
 }
 
-packet::Packet& object::PacketClassifiedObject::getPacket(size_t id) {
-    return packets->getPacket(id);
+packet::Packet object::PacketClassifiedObject::getPacket(size_t id) const {
+    return packets.getPacket(id);
 }
 
 void object::PacketClassifiedObject::setType(object::DeviceType newType) {
@@ -228,14 +462,41 @@ void object::PacketClassifiedObject::setAmountCutPackets(uint32_t cut) {
     this->amountCutPackets = cut;
 }
 
-void object::PacketClassifiedObject::addPacket(packet::Packet &pack) {
-    packets->addPacket(pack);
+void object::PacketClassifiedObject::setArrivalTime(size_t id, double time) {
+    amountRemoved++;
+    packets.setArrivalTime(id, time);
+}
+
+void object::PacketClassifiedObject::addPacket(const packet::Packet &pack) {
+    // Full ring of alive packets overwrites the oldest one, before the cut it is one of the first packets
+    if (packets.size() == packets.capacity()) {
+        if (needCut)
+            amountCutPackets++;
+        amountRemoved++;
+    }
+    amountAppended++;
+    packets.addPacket(pack);
+}
+
+void object::PacketClassifiedObject::addFragment(frames::LogFrame *frame) {
+    amountAppended++;
+    packets.addFragment(frame);
 }
 
 void object::PacketClassifiedObject::removeByIndex(size_t id) {
-    packets->removeByIndex(id);
+    amountRemoved++;
+    packets.removeByIndex(id);
 }
 
 void object::PacketClassifiedObject::removeFirstPackets(size_t cnt) {
-    packets->removeFirstPackets(cnt);
+    amountRemoved++;
+    packets.removeFirstPackets(cnt);
+}
+
+void object::PacketClassifiedObject::streamFirstPackets(size_t keep) {
+    if (!stream) return;
+    for (; packets.size() > keep; packets.removeFirstPackets(1)) {
+        packet::Packet first = packets.getPacket(0);
+        stream->addPacket(first.getSize(), first.getOffset(), first.getArrivalTime());
+    }
 }
\ No newline at end of file
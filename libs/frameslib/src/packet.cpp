@@ -7,27 +7,46 @@
 using namespace std;
 using namespace frameslib;
 
-packet::Packet::Packet(uint64_t id, uint64_t size_v, double time, vector<pair<uint64_t, double>> &&frags) {
+packet::Packet::Packet(uint64_t id, uint64_t size_v, double time, initializer_list<pair<uint64_t, double>> frags) {
     number = id;
     size = size_v;
     offset = time;
-    fragments = std::move(frags);
+    arrivalTime = 0;
+    for (const auto &frag : frags) {
+        if (fragsAmount < INLINE_FRAGMENTS)
+            fragments[fragsAmount] = {uint32_t(frag.first), frag.second};
+        fragsAmount++;
+    }
 }
 
-packet::Packet::~Packet() {
-    fragments.clear();
+packet::Packet::Packet(uint64_t id, uint64_t size_v, double time, double arrival, uint32_t fragsAmount) {
+    number = id;
+    size = size_v;
+    offset = time;
+    arrivalTime = arrival;
+    this->fragsAmount = fragsAmount;
+}
+
+void packet::Packet::appendFragment(uint64_t size_v, double offset_v) {
+    if (fragsAmount < INLINE_FRAGMENTS)
+        fragments[fragsAmount] = {uint32_t(size_v), offset_v};
+    fragsAmount++;
+    size += size_v;
+    offset = max(offset, offset_v);
 }
 
 void packet::Packet::addFragment(frames::LogFrame* frame) {
-    if (number != frame->getSeqNum() || fragments.size() - 1 == frame->getFragNum())
+    if (number != frame->getSeqNum() || uint64_t(fragsAmount) - 1 == frame->getFragNum())
         return;
-    fragments.emplace_back(frame->getSize(), frame->getOffset());
-    size += frame->getSize();
-    offset = max(offset, frame->getOffset());
+    appendFragment(frame->getSize(), frame->getOffset());
 }
 
 uint32_t packet::Packet::getFragSize() const {
-    return fragments.size();
+    return fragsAmount;
+}
+
+const packet::Fragment& packet::Packet::getFragment(size_t id) const {
+    return fragments[id];
 }
 
 uint64_t packet::Packet::getSeqNum() const {
@@ -50,6 +69,82 @@ void packet::Packet::setArrivalTime(double time) {
     arrivalTime = time;
 }
 
+packet::PacketHistory::PacketHistory(const vector<Packet> &packets) {
+    reserve(packets.size());
+    for (const auto &p : packets)
+        addPacket(p);
+}
+
+bool packet::PacketHistory::empty() const {
+    return sizes.empty();
+}
+
+size_t packet::PacketHistory::size() const {
+    return sizes.size();
+}
+
+void packet::PacketHistory::reserve(size_t n) {
+    seqNums.reserve(n);
+    sizes.reserve(n);
+    offsets.reserve(n);
+    arrivalTimes.reserve(n);
+    fragsAmounts.reserve(n);
+}
+
+void packet::PacketHistory::clear() {
+    seqNums.clear();
+    sizes.clear();
+    offsets.clear();
+    arrivalTimes.clear();
+    fragsAmounts.clear();
+}
+
+void packet::PacketHistory::addPacket(const Packet &pack) {
+    addPacket(uint16_t(pack.getSeqNum()), uint32_t(pack.getSize()), pack.getOffset(),
+              pack.getArrivalTime(), uint16_t(pack.getFragSize()));
+}
+
+void packet::PacketHistory::addPacket(uint16_t seqNum, uint32_t size, double offset, double arrivalTime,
+                                      uint16_t fragsAmount) {
+    seqNums.emplace_back(seqNum);
+    sizes.emplace_back(size);
+    offsets.emplace_back(offset);
+    arrivalTimes.emplace_back(arrivalTime);
+    fragsAmounts.emplace_back(fragsAmount);
+}
+
+packet::Packet packet::PacketHistory::getPacket(size_t id) const {
+    return Packet(seqNums[id], sizes[id], offsets[id], arrivalTimes[id], fragsAmounts[id]);
+}
+
+vector<packet::Packet> packet::PacketHistory::getPackets() const {
+    vector<Packet> res;
+    res.reserve(size());
+    for (size_t i = 0; i < size(); i++)
+        res.emplace_back(getPacket(i));
+    return res;
+}
+
+const vector<uint16_t>& packet::PacketHistory::getSeqNums() const {
+    return seqNums;
+}
+
+const vector<uint32_t>& packet::PacketHistory::getSizes() const {
+    return sizes;
+}
+
+const vector<double>& packet::PacketHistory::getOffsets() const {
+    return offsets;
+}
+
+const vector<double>& packet::PacketHistory::getArrivalTimes() const {
+    return arrivalTimes;
+}
+
+const vector<uint16_t>& packet::PacketHistory::getFragsAmounts() const {
+    return fragsAmounts;
+}
+
 map<uint64_t, vector<packet::Packet>> packet::collectPacketsByTA(const vector<frames::LogFrame> &frames) {
     // filter data frames
     vector<frames::LogFrame> dataFrames = utils::filter<frames::LogFrame>(frames, [](auto f) {
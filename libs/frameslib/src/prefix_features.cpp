@@ -0,0 +1,148 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/prefix_features.hpp"
+
+using namespace std;
+using namespace frameslib;
+
+features::OrderStatistics::OrderStatistics(vector<double> domain) :
+values(std::move(domain))
+{
+    sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+    tree.assign(values.size() + 1, 0);
+    highBit = 1;
+    while (highBit * 2 <= values.size()) highBit *= 2;
+}
+
+void features::OrderStatistics::add(double x) {
+    size_t id = lower_bound(values.begin(), values.end(), x) - values.begin() + 1;
+    for (; id < tree.size(); id += id & (~id + 1))
+        tree[id]++;
+    amount++;
+}
+
+size_t features::OrderStatistics::size() const {
+    return amount;
+}
+
+double features::OrderStatistics::kth(size_t rank) const {
+    // descend Fenwick tree to the last position with less than `rank` values before it
+    size_t pos = 0;
+    for (size_t step = highBit; step > 0; step >>= 1)
+        if (pos + step < tree.size() && tree[pos + step] < rank) {
+            pos += step;
+            rank -= tree[pos];
+        }
+    return values[pos];
+}
+
+size_t features::OrderStatistics::countNotGreater(double x) const {
+    size_t cnt = 0;
+    for (size_t id = upper_bound(values.begin(), values.end(), x) - values.begin(); id > 0; id -= id & (~id + 1))
+        cnt += tree[id];
+    return cnt;
+}
+
+double features::OrderStatistics::deviation(size_t id, size_t lowerAmount, double center) const {
+    // values not greater than center go first from the nearest one, then the greater ones
+    return id < lowerAmount ?
+        std::fabs(kth(lowerAmount - id) - center) :
+        std::fabs(kth(id + 1) - center);
+}
+
+double features::OrderStatistics::median() const {
+    if (amount % 2 != 0)
+        return kth(amount / 2 + 1);
+    return (kth(amount / 2) + kth(amount / 2 + 1)) / 2;
+}
+
+double features::OrderStatistics::medianAD(double center) const {
+    // deviations of lower and upper values form two sorted sequences,
+    // k-th deviation is found by binary search over amount taken from the lower one
+    size_t lower = countNotGreater(center), upper = amount - lower;
+    auto kthDeviation = [&](size_t k) {
+        size_t lo = k + 1 > upper ? k + 1 - upper : 0, hi = std::min(lower, k + 1);
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (deviation(mid, lower, center) < deviation(lower + k - mid, lower, center))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        size_t fromUpper = k + 1 - lo;
+        if (lo == 0) return deviation(lower + fromUpper - 1, lower, center);
+        if (fromUpper == 0) return deviation(lo - 1, lower, center);
+        return std::max(deviation(lo - 1, lower, center), deviation(lower + fromUpper - 1, lower, center));
+    };
+    if (amount % 2 != 0)
+        return kthDeviation(amount / 2);
+    return (kthDeviation(amount / 2 - 1) + kthDeviation(amount / 2)) / 2;
+}
+
+features::PrefixFeatureEngine::PrefixFeatureEngine(const packet::PacketHistory &history) :
+history(history)
+{
+    const vector<uint32_t> &sizes = history.getSizes();
+    sortedSizes = sizes;
+    sort(sortedSizes.begin(), sortedSizes.end());
+    sortedSizes.erase(unique(sortedSizes.begin(), sortedSizes.end()), sortedSizes.end());
+    sizeAmounts.assign(sortedSizes.size(), 0);
+    sizeOrder = OrderStatistics(vector<double>(sizes.begin(), sizes.end()));
+    vector<double> intervals(history.size());
+    for (size_t i = 0; i < intervals.size(); i++)
+        intervals[i] = getInterval(i);
+    intervalOrder = OrderStatistics(std::move(intervals));
+}
+
+double features::PrefixFeatureEngine::getInterval(size_t id) const {
+    return id == 0 ?
+        history.getArrivalTimes()[0] :
+        history.getOffsets()[id] - history.getOffsets()[id - 1];
+}
+
+bool features::PrefixFeatureEngine::next() {
+    if (amount == history.size()) return false;
+    uint32_t size = history.getSizes()[amount];
+    // UniqueFeatures
+    size_t sizeId = lower_bound(sortedSizes.begin(), sortedSizes.end(), size) - sortedSizes.begin();
+    if (sizeAmounts[sizeId] > 0)
+        frequency.erase({-int64_t(sizeAmounts[sizeId]), size});
+    sizeAmounts[sizeId]++;
+    frequency.insert({-int64_t(sizeAmounts[sizeId]), size});
+    totalSize += size;
+    MTU = std::max(MTU, uint64_t(size));
+    if (amount == 0)
+        firstSize = size;
+    else if (!secondSize.has_value() && size != firstSize)
+        secondSize = size;
+    // StandardFeatures
+    sizeMoments.add(double(size));
+    sizeOrder.add(double(size));
+    double interval = getInterval(amount);
+    intervalMoments.add(interval);
+    intervalOrder.add(interval);
+    amount++;
+    return true;
+}
+
+size_t features::PrefixFeatureEngine::size() const {
+    return amount;
+}
+
+vector<double> features::PrefixFeatureEngine::getUniqueFeatures() const {
+    double pivotSize = double(MTU);
+    if (secondSize.has_value()) {
+        // the first size in arrival order which isn't MTU
+        uint64_t first = firstSize != MTU ? firstSize : secondSize.value();
+        // the most frequent size except MTU, the least one among equally frequent
+        auto best = frequency.begin();
+        if (best->second == MTU) ++best;
+        size_t firstId = lower_bound(sortedSizes.begin(), sortedSizes.end(), first) - sortedSizes.begin();
+        pivotSize = int64_t(sizeAmounts[firstId]) == -best->first ? double(first) : double(best->second);
+    }
+    // pivot size / MTU size, pivot size / total sample size
+    return {pivotSize, pivotSize / double(MTU), pivotSize / double(totalSize)};
+}
@@ -0,0 +1,194 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/sketch_features.hpp"
+
+using namespace std;
+using namespace frameslib;
+
+const int features::QuantileSketch::SUB_BINS;
+const int features::QuantileSketch::MIN_EXP;
+const int features::QuantileSketch::MAX_EXP;
+const int32_t features::QuantileSketch::HALF_BINS;
+const size_t features::QuantileSketch::BINS;
+const size_t features::StreamingFeatures::SIZES_CAPACITY;
+
+int32_t features::QuantileSketch::binOf(double x) {
+    double mag = std::fabs(x);
+    if (mag < std::ldexp(1.0, MIN_EXP))
+        return 0;
+    int exp;
+    double fraction = std::frexp(mag, &exp);
+    int32_t bin = HALF_BINS;
+    if (exp <= MAX_EXP)
+        // mag = (1 + t) * 2^(exp - 1), t = 2 * fraction - 1 in [0, 1)
+        bin = (exp - MIN_EXP - 1) * SUB_BINS + int32_t((2 * fraction - 1) * SUB_BINS) + 1;
+    return x < 0 ? -bin : bin;
+}
+
+double features::QuantileSketch::representative(int32_t bin) {
+    if (bin == 0) return 0;
+    int32_t mag = std::abs(bin) - 1;
+    double value = std::ldexp(1.0 + (mag % SUB_BINS + 0.5) / SUB_BINS, mag / SUB_BINS + MIN_EXP);
+    return bin < 0 ? -value : value;
+}
+
+void features::QuantileSketch::add(double x) {
+    counts[binOf(x) + HALF_BINS]++;
+    amount++;
+}
+
+void features::QuantileSketch::merge(const QuantileSketch &other) {
+    for (size_t i = 0; i < BINS; i++)
+        counts[i] += other.counts[i];
+    amount += other.amount;
+}
+
+uint64_t features::QuantileSketch::size() const {
+    return amount;
+}
+
+double features::QuantileSketch::kth(uint64_t rank) const {
+    uint64_t cnt = 0;
+    size_t last = 0;
+    for (size_t i = 0; i < BINS; i++) {
+        if (counts[i] == 0) continue;
+        cnt += counts[i];
+        last = i;
+        if (cnt >= rank)
+            break;
+    }
+    return representative(int32_t(last) - HALF_BINS);
+}
+
+double features::QuantileSketch::median() const {
+    if (amount % 2 != 0)
+        return kth(amount / 2 + 1);
+    return (kth(amount / 2) + kth(amount / 2 + 1)) / 2;
+}
+
+double features::QuantileSketch::medianAD(double center) const {
+    // deviations grow from center outwards on both sides, so bins are merged without sorting
+    const uint64_t lowRank = amount % 2 != 0 ? amount / 2 + 1 : amount / 2, highRank = amount / 2 + 1;
+    double low = 0, high = 0;
+    bool lowFound = false;
+    uint64_t cnt = 0;
+    // bins before `below` are below center, bins from `above` are not
+    size_t above = 0;
+    while (above < BINS && representative(int32_t(above) - HALF_BINS) < center)
+        above++;
+    size_t below = above;
+    while (cnt < highRank) {
+        while (below > 0 && counts[below - 1] == 0)
+            below--;
+        while (above < BINS && counts[above] == 0)
+            above++;
+        if (below == 0 && above == BINS)
+            break;
+        double lower = below > 0 ? center - representative(int32_t(below - 1) - HALF_BINS) : INFINITY;
+        double upper = above < BINS ? representative(int32_t(above) - HALF_BINS) - center : INFINITY;
+        if (lower <= upper) {
+            high = lower;
+            cnt += counts[--below];
+        } else {
+            high = upper;
+            cnt += counts[above++];
+        }
+        if (!lowFound && cnt >= lowRank) {
+            low = high;
+            lowFound = true;
+        }
+    }
+    return (low + high) / 2;
+}
+
+void features::StreamingFeatures::countSize(uint32_t size) {
+    size_t least = 0;
+    for (size_t i = 0; i < sizesUsed; i++) {
+        if (sizes[i] == size) {
+            sizeAmounts[i]++;
+            return;
+        }
+        if (sizeAmounts[i] < sizeAmounts[least])
+            least = i;
+    }
+    if (sizesUsed < SIZES_CAPACITY) {
+        sizes[sizesUsed] = size;
+        sizeAmounts[sizesUsed++] = 1;
+        return;
+    }
+    // new size replaces the least frequent one and inherits its amount
+    sizes[least] = size;
+    sizeAmounts[least]++;
+}
+
+uint64_t features::StreamingFeatures::getSizeAmount(uint32_t size) const {
+    for (size_t i = 0; i < sizesUsed; i++)
+        if (sizes[i] == size)
+            return sizeAmounts[i];
+    return 0;
+}
+
+void features::StreamingFeatures::addPacket(uint64_t size, double offset, double arrivalTime) {
+    // UniqueFeatures
+    countSize(uint32_t(size));
+    totalSize += size;
+    MTU = std::max(MTU, size);
+    if (amount == 0)
+        firstSize = size;
+    else if (!secondSize.has_value() && size != firstSize)
+        secondSize = size;
+    // StandardFeatures
+    sizeMoments.add(double(size));
+    sizeSketch.add(double(size));
+    double interval = amount == 0 ? arrivalTime : offset - lastOffset;
+    intervalMoments.add(interval);
+    intervalSketch.add(interval);
+    lastOffset = offset;
+    amount++;
+}
+
+void features::StreamingFeatures::addPackets(const packet::PacketHistory &history) {
+    for (size_t i = 0; i < history.size(); i++)
+        addPacket(history.getSizes()[i], history.getOffsets()[i], history.getArrivalTimes()[i]);
+}
+
+uint64_t features::StreamingFeatures::size() const {
+    return amount;
+}
+
+vector<double> features::StreamingFeatures::getUniqueFeatures() const {
+    // the first size in arrival order which isn't MTU
+    double pivotSize = double(MTU);
+    if (secondSize.has_value())
+        pivotSize = double(firstSize != MTU ? firstSize : secondSize.value());
+    // it is replaced by the most frequent size which isn't MTU, the least one of equally frequent
+    uint32_t bestSize = 0;
+    uint64_t bestAmount = 0;
+    for (size_t i = 0; i < sizesUsed; i++)
+        if (sizes[i] != MTU && (sizeAmounts[i] > bestAmount || (sizeAmounts[i] == bestAmount && sizes[i] < bestSize))) {
+            bestSize = sizes[i];
+            bestAmount = sizeAmounts[i];
+        }
+    if (bestAmount > getSizeAmount(uint32_t(pivotSize)))
+        pivotSize = double(bestSize);
+    // pivot size / MTU size, pivot size / total sample size
+    return {pivotSize, pivotSize / double(MTU), pivotSize / double(totalSize)};
+}
+
+vector<double> features::StreamingFeatures::getFeatures(const unordered_set<size_t> &skips) const {
+    vector<double> tmp, curFeatures;
+    curFeatures = getUniqueFeatures();
+    double median = sizeSketch.median();
+    tmp = StandardFeatures(sizeMoments, median, sizeSketch.medianAD(median)).toVector();
+    curFeatures.insert(curFeatures.end(), tmp.begin(), tmp.end());
+    median = intervalSketch.median();
+    tmp = StandardFeatures(intervalMoments, median, intervalSketch.medianAD(median)).toVector();
+    curFeatures.insert(curFeatures.end(), tmp.begin(), tmp.end());
+    tmp = curFeatures;
+    curFeatures.clear();
+    for (size_t i = 0; i < tmp.size(); i++)
+        if (!utils::checkExist(i, skips)) curFeatures.emplace_back(tmp[i]);
+    return curFeatures;
+}
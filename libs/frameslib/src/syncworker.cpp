@@ -7,238 +7,313 @@
 using namespace std;
 using namespace frameslib;
 
-frames::syncworker::SyncPacket::SyncPacket(LogFrame frame)
-: packet::Packet(frame.getSeqNum(), frame.getSize(), frame.getOffset(), {{frame.getSeqNum(), frame.getOffset()}}) {
-    this->frags = {frame.getFragNum()};
+namespace {
+    const uint16_t SEQ_SPACE = 4096;
+    const uint16_t SEQ_MASK = SEQ_SPACE - 1;
+    const size_t MAX_FRAGMENTS = 16;
+    /// Amount of late frames in a row after which sender is considered to restart its sequence numbers.
+    const size_t MAX_LATE_FRAMES = 8;
+    /// Late frame which came so many seconds after the last released packet restarts sequence at once.
+    const double RESYNC_INTERVAL = 1.0;
 }
 
-void frames::syncworker::SyncPacket::addFragment(LogFrame* frame) {
-    if (number != frame->getSeqNum() || frags.find(frame->getFragNum()) != frags.end())
-        return;
-    fragments.emplace_back(frame->getSize(), frame->getOffset());
-    frags.insert(frame->getFragNum());
-    size += frame->getSize();
-    offset = max(offset, frame->getOffset());
-}
-
-frames::syncworker::SyncPacketWorker::SyncPacketWorker(const size_t packetsAmountThreshold)
-    : packetsAmountThreshold(packetsAmountThreshold) {
-    packets = {};
-    expectedFragsSizes = {};
-    readyPackets = {};
-}
-
-bool frames::syncworker::SyncPacketWorker::addFragment(LogFrame frame) {
-    std::unique_lock<std::recursive_mutex> _ul(_lock);
-    if (readyToWork) return readyToWork;
-    if (packets.empty()) {
-        SyncPacket p(frame);
-        packets.emplace_back(p);
-        expectedFragsSizes.emplace_back(!frame.getMoreFrags() ? frame.getFragNum() + 1 : frame.getFragNum() + 2);
-        readyPackets.emplace_back(p.getFragSize() - 1 == frame.getFragNum() && !frame.getMoreFrags());
-        return false;
-    }
+bool frames::syncworker::SyncPacketWorker::Slot::isComplete() const {
+    return fragsTotal != 0 && fragsMask == uint16_t((1u << fragsTotal) - 1);
+}
 
-//    // Try to write normal structure
-//    const uint64_t seqNum = frame.getSeqNum();
-//    const float offset = frame.getOffset();
-//    int ind_offset = 0;
-//    for (; ind_offset < packets.size() && packets[ind_offset].getOffset() < offset; ind_offset++);
-//
-//    if (ind_offset == 0 && !needCut) return readyToWork;
-//
-//    // Check extreme cases
-//    if (ind_offset == 0 || ind_offset == packets.size()) {
-//        if (ind_offset == packets.size()) ind_offset--;
-//        if (packets[ind_offset].getSeqNum() == seqNum) {
-//            packets[ind_offset].addFragment(&frame);
-//            expectedFragsSizes[ind_offset] = !frame.getMoreFrags() ?
-//                                             int(frame.getFragNum() + 1) :
-//                                             std::max(expectedFragsSizes[ind_offset], int(frame.getFragNum() + 2));
-//            readyPackets[ind_offset] = expectedFragsSizes[ind_offset] == packets[ind_offset].getFragSize();
-//            tryCut();
-//            if (!readyToWork)
-//                readyToWork = !needCut && count() >= global_vars::packetsAmountNeedForClassifier;
-//            return readyToWork;
-//        }
-//        // Try to find packet with seqNum in packets
-//        int ind_seq = 0;
-//        for (; ind_seq < packets.size() && packets[ind_seq].getSeqNum() != seqNum; ind_seq++);
-//        if (ind_seq == packets.size()) {
-//            if (ind_offset == 0 && !needCut) return readyToWork;
-//            SyncPacket p(frame);
-//            packets.insert(packets.begin() + ind_offset, p);
-//            expectedFragsSizes.insert(expectedFragsSizes.begin() + ind_offset,
-//                                      !frame.getMoreFrags() ? frame.getFragNum() + 1 : frame.getFragNum() + 2);
-//            readyPackets.insert(readyPackets.begin() + ind_offset,
-//                                p.getFragSize() - 1 == frame.getFragNum() && !frame.getMoreFrags());
-//            tryCut();
-//            if (!readyToWork)
-//                readyToWork = !needCut && count() >= global_vars::packetsAmountNeedForClassifier;
-//            return readyToWork;
-//        } else {
-//            packets[ind_seq].addFragment(&frame);
-//            expectedFragsSizes[ind_seq] = !frame.getMoreFrags() ?
-//                                             int(frame.getFragNum() + 1) :
-//                                             std::max(expectedFragsSizes[ind_seq], int(frame.getFragNum() + 2));
-//            readyPackets[ind_seq] = expectedFragsSizes[ind_seq] == packets[ind_seq].getFragSize();
-//            tryCut();
-//            if (!readyToWork)
-//                readyToWork = !needCut && count() >= global_vars::packetsAmountNeedForClassifier;
-//            return readyToWork;
-//        }
-//    } else {
-//        // Check [0..x] cur [x+1...]
-//        // Check ∈ [x + 1]
-//        if (packets[ind_offset].getSeqNum() == seqNum) {
-//            packets[ind_offset].addFragment(&frame);
-//            expectedFragsSizes[ind_offset] = !frame.getMoreFrags() ?
-//                                             int(frame.getFragNum() + 1) :
-//                                             std::max(expectedFragsSizes[ind_offset], int(frame.getFragNum() + 2));
-//            readyPackets[ind_offset] = expectedFragsSizes[ind_offset] == packets[ind_offset].getFragSize();
-//            tryCut();
-//            if (!readyToWork)
-//                readyToWork = !needCut && count() >= global_vars::packetsAmountNeedForClassifier;
-//            return readyToWork;
-//        } else
-//            // Check ∈ [x]
-//            if (packets[ind_offset - 1].getSeqNum() == seqNum) {
-//            packets[ind_offset - 1].addFragment(&frame);
-//            expectedFragsSizes[ind_offset - 1] = !frame.getMoreFrags() ?
-//                                             int(frame.getFragNum() + 1) :
-//                                             std::max(expectedFragsSizes[ind_offset - 1], int(frame.getFragNum() + 2));
-//            readyPackets[ind_offset - 1] = expectedFragsSizes[ind_offset - 1] == packets[ind_offset - 1].getFragSize();
-//            tryCut();
-//            if (!readyToWork)
-//                readyToWork = !needCut && count() >= global_vars::packetsAmountNeedForClassifier;
-//            return readyToWork;
-//        } else {
-//            // Try to find packet with seqNum in packets
-//            int ind_seq = 0;
-//            for (; ind_seq < packets.size() && packets[ind_seq].getSeqNum() < seqNum; ind_seq++);
-//
-//        }
-//    }
-
-    // Need more useful and powerful structure
-    const uint64_t seqNum = frame.getSeqNum();
-    int ind = 0;
-    for (; ind < packets.size() && packets[ind].getSeqNum() < seqNum; ind++);
-
-    // We cut first packets and now try to insert in begin
-    if (ind == 0 && !needCut) return readyToWork;
-
-    if (ind == packets.size() || packets[ind].getSeqNum() > seqNum) {
-        SyncPacket p(frame);
-        packets.insert(packets.begin() + ind, p);
-        expectedFragsSizes.insert(expectedFragsSizes.begin() + ind,
-                                  !frame.getMoreFrags() ? frame.getFragNum() + 1 : frame.getFragNum() + 2);
-        readyPackets.insert(readyPackets.begin() + ind,
-                            p.getFragSize() - 1 == frame.getFragNum() && !frame.getMoreFrags());
-        tryCut();
-        if (!readyToWork)
-            readyToWork = !needCut && count() >= packetsAmountThreshold;
-        return readyToWork;
+frames::syncworker::SyncPacketWorker::SyncPacketWorker(const size_t packetsAmountThreshold,
+                                                       const size_t reorderWindow)
+    : readyToWork(false), packetsAmountThreshold(packetsAmountThreshold) {
+    size_t w = 1;
+    while (w < min(reorderWindow, size_t(SEQ_SPACE / 2))) w <<= 1;
+    window.resize(w);
+}
+
+void frames::syncworker::SyncPacketWorker::release(const Slot &slot) {
+    if (needCut && !history.empty() && slot.size < history.getSizes().back()) {
+        // Sizes stop growing: cut all packets except the previous one
+        packet::Packet last = history.getPacket(history.size() - 1);
+        history.clear();
+        history.addPacket(last);
+        needCut = false;
     }
-    packets[ind].addFragment(&frame);
-    expectedFragsSizes[ind] = !frame.getMoreFrags() ?
-                              int(frame.getFragNum() + 1) :
-                              std::max(expectedFragsSizes[ind], int(frame.getFragNum() + 2));
-    readyPackets[ind] = expectedFragsSizes[ind] == packets[ind].getFragSize();
-    tryCut();
-    if (!readyToWork)
-        readyToWork = !needCut && count() >= packetsAmountThreshold;
-    return readyToWork;
+    // Arrival time of packet is the interval since the previous released one
+    double arrival = history.empty() ? 0.0 : slot.offset - history.getOffsets().back();
+    history.addPacket(slot.seqNum, slot.size, slot.offset, arrival,
+                      uint16_t(bitset<MAX_FRAGMENTS>(slot.fragsMask).count()));
+}
+
+void frames::syncworker::SyncPacketWorker::advance() {
+    Slot &front = window[base & (window.size() - 1)];
+    if (front.used && front.isComplete())
+        release(front);
+    front = Slot();
+    base = (base + 1) & SEQ_MASK;
+    if (span > 0) span--;
 }
 
-void frames::syncworker::SyncPacketWorker::tryCut() {
-//    std::unique_lock<std::recursive_mutex> _ul(_lock);
-    if (!needCut) return;
-    if (packets.size() < 2) return;
-    uint64_t ind = 1;
-    if (!readyPackets[0]) return;
-    for (; ind < packets.size() && readyPackets[ind] && packets[ind].getSize() >= packets[ind - 1].getSize(); ind++);
-    if (ind == packets.size())
+void frames::syncworker::SyncPacketWorker::flush() {
+    while (span > 0)
+        advance();
+}
+
+void frames::syncworker::SyncPacketWorker::releaseComplete() {
+    // The first sequence number is unknown: hold packets until half of the window is used,
+    // so that reordered frames from the beginning of the stream aren't late
+    if (history.empty() && span < window.size() / 2)
         return;
-    if (ind >= 1 && packets[ind].getSize() < packets[ind - 1].getSize()) {
-        packets.erase(packets.begin(), packets.begin() + ind - 1);
-        readyPackets.erase(readyPackets.begin(), readyPackets.begin() + ind - 1);
-        expectedFragsSizes.erase(expectedFragsSizes.begin(), expectedFragsSizes.begin() + ind - 1);
-        needCut = false;
+    while (span > 0) {
+        const Slot &front = window[base & (window.size() - 1)];
+        if (!front.used || !front.isComplete())
+            break;
+        advance();
+    }
+}
+
+bool frames::syncworker::SyncPacketWorker::addFragment(LogFrame &frame) {
+    if (readyToWork) return true;
+    const auto seqNum = uint16_t(frame.getSeqNum() & SEQ_MASK);
+    const uint64_t fragNum = frame.getFragNum();
+    if (fragNum >= MAX_FRAGMENTS) return false;
+    if (!started) {
+        base = seqNum;
+        started = true;
+    }
+    size_t dist = (seqNum - base) & SEQ_MASK;
+    if (dist >= SEQ_SPACE / 2) {
+        // Frame is behind the window, accept it only before the first release
+        size_t back = SEQ_SPACE - dist;
+        if (history.empty() && span + back <= window.size()) {
+            base = seqNum;
+            span += back;
+        } else {
+            bool farAhead = !history.empty() && frame.getOffset() - history.getOffsets().back() > RESYNC_INTERVAL;
+            if (++lateFrames < MAX_LATE_FRAMES && !farAhead)
+                return false;
+            // Sequence numbers were restarted: release what waits and move the window to the frame
+            flush();
+            base = seqNum;
+        }
+        dist = 0;
     }
+    lateFrames = 0;
+    while (dist >= window.size() && span > 0) {
+        advance();
+        dist--;
+    }
+    if (dist >= window.size()) {
+        // Nothing waits in the window, jump to the frame
+        base = seqNum;
+        dist = 0;
+    }
+    Slot &slot = window[seqNum & (window.size() - 1)];
+    if (!slot.used) {
+        slot.used = true;
+        slot.seqNum = seqNum;
+        slot.offset = frame.getOffset();
+    }
+    span = max(span, dist + 1);
+    const auto bit = uint16_t(1u << fragNum);
+    if (slot.fragsMask & bit) return false;
+    slot.fragsMask |= bit;
+    slot.size += frame.getSize();
+    slot.offset = max(slot.offset, frame.getOffset());
+    if (!frame.getMoreFrags())
+        slot.fragsTotal = uint8_t(fragNum + 1);
+    releaseComplete();
+    readyToWork = !needCut && count() >= packetsAmountThreshold;
+    return readyToWork;
 }
 
-int frames::syncworker::SyncPacketWorker::count() {
-//    std::unique_lock<std::recursive_mutex> _ul(_lock);
-    int ind = 0;
-    for (; ind < readyPackets.size() && readyPackets[ind]; ind++);
-    return ind;
+size_t frames::syncworker::SyncPacketWorker::count() const {
+    return history.size();
 }
 
 vector<packet::Packet> frames::syncworker::SyncPacketWorker::getPackets() {
-    std::unique_lock<std::recursive_mutex> _ul(_lock);
     vector<packet::Packet>res;
     res.reserve(packetsAmountThreshold);
-    for (int i = 0; i < packetsAmountThreshold; i++)
-        res.emplace_back(packets[i]);
+    for (size_t i = 0; i < min(packetsAmountThreshold, history.size()); i++)
+        res.emplace_back(history.getPacket(i));
     return res;
 }
 
+const packet::PacketHistory& frames::syncworker::SyncPacketWorker::getHistory() const {
+    return history;
+}
+
 bool frames::syncworker::SyncPacketWorker::isReadyToWork() const {
     return readyToWork;
 }
 
 void frames::syncworker::SyncPacketWorker::reset() {
-    std::unique_lock<std::recursive_mutex> _ul(_lock);
     needCut = true;
+    started = false;
+    fill(window.begin(), window.end(), Slot());
+    base = 0;
+    span = 0;
+    lateFrames = 0;
+    history.clear();
     readyToWork = false;
 }
 
-frames::syncworker::SyncFrameWorker::SyncFrameWorker(int threads_cnt) : threads_cnt(threads_cnt) {}
+frames::syncworker::SyncFrameWorker::Shard::Shard(size_t queueCapacity)
+: frames(queueCapacity), handled(0), sleeping(false) {}
 
-int frames::syncworker::SyncFrameWorker::readFramesFromFile(const string &path, queue<SyncPacketWorker *> &queue, bool oldFileFormat) {
-    int count = 0;
-    int expectedCount = oldFileFormat ? 3 : 2;
-    vector<string> lines(expectedCount);
-    ThreadPool threadPool(threads_cnt);
-    ifstream in(path);
-    if (in.is_open()) {
-        string line;
-        while (getline(in, line, '\n')) {
-            // skip empty string
-            smatch match;
-            if (regex_match(line, match, regex("^\\s*$"))) {
-                continue;
-            }
+frames::syncworker::SyncFrameWorker::SyncFrameWorker(int threads_cnt,
+                                                     size_t packetsAmountThreshold,
+                                                     size_t queueCapacity)
+: packetsAmountThreshold(packetsAmountThreshold) {
+    threads_cnt = max(threads_cnt, 1);
+    shards.reserve(threads_cnt);
+    for (int i = 0; i < threads_cnt; i++)
+        shards.emplace_back(new Shard(queueCapacity));
+    for (auto &shard : shards)
+        shard->thread = thread(&SyncFrameWorker::shardWork, this, shard.get());
+}
 
-            // remeber string
-            lines[count++] = line;
-            if (count == expectedCount) {
-                count = 0;
-                threadPool.add_job(std::bind(&SyncFrameWorker::frameHandling, this, vector<string> (lines),queue , oldFileFormat));
-            }
+frames::syncworker::SyncFrameWorker::~SyncFrameWorker() {
+    for (auto &shard : shards) {
+        std::unique_lock<std::mutex> _ul(shard->_lock);
+        shard->shutdown = true;
+        shard->_cond_var.notify_one();
+    }
+    for (auto &shard : shards)
+        shard->thread.join();
+}
+
+size_t frames::syncworker::SyncFrameWorker::route(uint64_t TA) const {
+    // Vendors fill MACs unevenly, so mix bits before taking the shard
+    return size_t((TA * 0x9E3779B97F4A7C15ULL) >> 32) % shards.size();
+}
+
+void frames::syncworker::SyncFrameWorker::shardWork(Shard *shard) {
+    const size_t spins = 64;
+    size_t idle = 0;
+    while (true) {
+        if (shard->frames.consume([this, shard](Input &input) { frameHandling(shard, input); })) {
+            shard->handled.fetch_add(1, memory_order_release);
+            idle = 0;
+            continue;
         }
-    } else return -1;
-    in.close();
-    return 0;
+        if (++idle < spins) {
+            this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> _ul(shard->_lock);
+        if (shard->shutdown && shard->frames.empty())
+            return;
+        shard->sleeping.store(true);
+        // Timeout covers the wakeup missed between the check and the wait
+        shard->_cond_var.wait_for(_ul, chrono::milliseconds(1), [shard] {
+            return shard->shutdown || !shard->frames.empty();
+        });
+        shard->sleeping.store(false);
+        idle = 0;
+    }
+}
+
+void frames::syncworker::SyncFrameWorker::frameHandling(Shard *shard, Input &input) {
+    LogFrame &frame = input.frame;
+    if (!input.lines.empty()) {
+        frame = parse(input.lines, true, true, input.oldFileFormat);
+        if (!frame.getTA().has_value()
+            || !frame.getType().has_value()
+            || frame.getType().value().find("Data", 0) == string::npos) return;
+    }
+    object::MacTable::id_t id = shard->macs.intern(frame.getTA().value());
+    while (shard->packetsByAddress.size() <= id) {
+        shard->packetsByAddress.emplace_back(packetsAmountThreshold);
+        shard->alreadyAddToQueue.emplace_back(false);
+    }
+    SyncPacketWorker &worker = shard->packetsByAddress[id];
+    if (worker.addFragment(frame) && !shard->alreadyAddToQueue[id]) {
+        shard->alreadyAddToQueue[id] = true;
+        ready.push(&worker);
+    }
+}
+
+void frames::syncworker::SyncFrameWorker::dispatch(Input &&input, uint64_t TA) {
+    Shard *shard = shards[route(TA)].get();
+    while (!shard->frames.tryPush(std::move(input)))
+        this_thread::yield();
+    shard->routed++;
+    if (shard->sleeping.load()) {
+        std::unique_lock<std::mutex> _ul(shard->_lock);
+        shard->_cond_var.notify_one();
+    }
 }
 
-void frames::syncworker::SyncFrameWorker::frameHandling(const vector<string> lines, std::queue<SyncPacketWorker *> &queue, bool oldFileFormat) {
-    LogFrame frame = parse(lines, true, true, oldFileFormat);
+void frames::syncworker::SyncFrameWorker::frameHandle(LogFrame &frame) {
     if (!frame.getTA().has_value()
         || !frame.getType().has_value()
         || frame.getType().value().find("Data", 0) == string::npos) return;
-    auto TA = frame.getTA().value();
-    if (packetsByAddress[TA].addFragment(frame)) {
-        std::unique_lock<std::recursive_mutex> _ul(_lock);
-        if (alreadyAddToQueue.find(TA) == alreadyAddToQueue.end() || !alreadyAddToQueue[TA]) {
-            queue.push(&packetsByAddress[TA]);
-            alreadyAddToQueue[TA] = true;
+    uint64_t TA = frame.getTA().value();
+    Input input;
+    input.frame = std::move(frame);
+    dispatch(std::move(input), TA);
+}
+
+void frames::syncworker::SyncFrameWorker::flush() {
+    for (auto &shard : shards)
+        while (shard->handled.load(memory_order_acquire) < shard->routed)
+            this_thread::yield();
+}
+
+bool frames::syncworker::SyncFrameWorker::popReady(SyncPacketWorker *&worker) {
+    return ready.tryPop(worker);
+}
+
+int frames::syncworker::SyncFrameWorker::readFramesFromStream(istream &in,
+                                                              queue<SyncPacketWorker *> &queue,
+                                                              bool oldFileFormat) {
+    int count = 0;
+    int expectedCount = oldFileFormat ? 3 : 2;
+    Input input;
+    input.lines.resize(expectedCount);
+    input.oldFileFormat = oldFileFormat;
+    string line;
+    while (getline(in, line, '\n')) {
+        // skip empty string
+        if (utils::isBlank(line)) continue;
+        // remeber string
+        input.lines[count++] = std::move(line);
+        if (count == expectedCount) {
+            count = 0;
+            // frames without TA are dropped by parse anyway, others are parsed by their shards
+            tl::optional<uint64_t> TA = findTA(input.lines.back());
+            if (TA.has_value()) {
+                dispatch(std::move(input), TA.value());
+                input.lines.assign(expectedCount, string());
+            }
         }
     }
+    flush();
+    SyncPacketWorker *worker;
+    while (popReady(worker))
+        queue.push(worker);
+    if (0 < count && count < expectedCount) return -2;
+    return 0;
+}
+
+int frames::syncworker::SyncFrameWorker::readFramesFromFile(const string &path,
+                                                            queue<SyncPacketWorker *> &queue,
+                                                            bool oldFileFormat) {
+    ifstream in(path);
+    int exitCode;
+    if (in.is_open())
+        exitCode = readFramesFromStream(in, queue, oldFileFormat);
+    else return -1;
+    in.close();
+    return exitCode;
 }
 
 void frames::syncworker::SyncFrameWorker::reset() {
-    packetsByAddress.clear();
-    alreadyAddToQueue.clear();
+    flush();
+    for (auto &shard : shards) {
+        shard->macs.clear();
+        shard->packetsByAddress.clear();
+        shard->alreadyAddToQueue.clear();
+    }
+    SyncPacketWorker *worker;
+    while (ready.tryPop(worker));
 }
@@ -77,6 +77,10 @@ string frameslib::utils::strToLower(string s) {
     return s;
 }
 
+bool frameslib::utils::isBlank(const string &s) {
+    return all_of(s.begin(), s.end(), [](unsigned char c) { return isspace(c) != 0; });
+}
+
 bool frameslib::utils::checkRetransmission(uint64_t a, uint64_t b, uint64_t c) {
     return a < c && (a < b && b > c || a > b && b < c) || a > b && b > c;
 }
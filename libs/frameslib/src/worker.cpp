@@ -7,8 +7,11 @@
 using namespace std;
 using namespace frameslib;
 
-frames::worker::Worker::Worker(const size_t packetsAmountThreshold)
-: packetsAmountThreshold(packetsAmountThreshold) {
+const frames::worker::Worker::handle_t frames::worker::Worker::NONE = UINT32_MAX;
+const size_t frames::worker::Worker::STREAMING_TAIL;
+
+frames::worker::Worker::Worker(const size_t packetsAmountThreshold, shared_ptr<object::MacTable> macs)
+: macs(std::move(macs)), packetsAmountThreshold(packetsAmountThreshold) {
     objects = {};
     queue = {};
 }
@@ -17,41 +20,57 @@ frames::worker::Worker::~Worker() {
     clear();
 }
 
+bool frames::worker::Worker::isPacketFrame(LogFrame &frame) {
+    return frame.getType().has_value()
+           && frame.getTA().has_value() && frame.getTA().value() != graph::BROADCAST
+           && frame.getType().value().find("Data", 0) != string::npos;
+}
+
 void frames::worker::Worker::frameHandle(LogFrame &frame) {
+    // Other frames don't make objects, so their TAs aren't interned
+    if (isPacketFrame(frame))
+        frameHandle(frame, macs->intern(frame.getTA().value()));
+}
+
+void frames::worker::Worker::frameHandle(LogFrame &frame, id_t id) {
     // Check frame's type
-    if (frame.getType().has_value()
-        && frame.getTA().has_value() && frame.getTA().value() != graph::BROADCAST
-        && frame.getType().value().find("Data", 0) != string::npos) {
+    if (isPacketFrame(frame)) {
         // Check that the object is ready
         uint64_t TA = frame.getTA().value();
         // Make new object if necessary
-        if (objects.find(TA) == objects.end())
-            objects[TA] = make_shared<object::PacketClassifiedObject>(TA, object::Unknown, packetsAmountThreshold);
-        std::shared_ptr<object::PacketClassifiedObject>& obj = objects[TA];
+        if (id >= objects.size())
+            objects.resize(macs->range(), NONE);
+        handle_t &handle = objects[id];
+        if (handle == NONE)
+            handle = streaming ?
+                     pool.create(TA, object::Unknown, STREAMING_TAIL + 1, true) :
+                     pool.create(TA, object::Unknown, packetsAmountThreshold);
+        object::PacketClassifiedObject *obj = &pool.get(handle);
         if (obj->isReady())
             return;
         // Add frame at the packet if necessary
-        if (obj->isPacketsEmpty() || frame.getSeqNum() != obj->getPackets().back().getSeqNum()) {
+        size_t amount = obj->getPacketsAmount();
+        if (amount == 0 || frame.getSeqNum() != obj->getPacket(amount - 1).getSeqNum()) {
             // Check that amount of packets equals to packetsAmountNeedForClassifier
-            if (!obj->isNeedCut() && obj->getPackets().size() >= packetsAmountThreshold) {
+            if (!obj->isNeedCut() && obj->getWindowSize() >= packetsAmountThreshold) {
                 obj->setReady(true);
-                queue.push(obj);
+                queue.push(handle);
                 return;
             }
             // Check that we need to cut first packets
-            if (obj->isNeedCut()) {
-                uint64_t predLast = obj->getPackets().size() - 2;
-                if (obj->getPackets().size() > 1 &&
-                    obj->getPackets()[predLast + 1].getSize() < obj->getPackets()[predLast].getSize()) {
+            if (obj->isNeedCut() && amount > 1) {
+                packet::Packet predLast = obj->getPacket(amount - 2);
+                packet::Packet last = obj->getPacket(amount - 1);
+                if (last.getSize() < predLast.getSize()) {
                     // Cut first packets
                     double time;
-                    if (predLast == 0)
-                        time = obj->getPackets()[predLast + 1].getOffset();
+                    if (amount == 2)
+                        time = last.getOffset();
                     else
-                        time = obj->getPackets()[predLast + 1].getOffset() - obj->getPackets()[predLast].getOffset();
-                    obj->getPacket(predLast + 1).setArrivalTime(time);
-                    obj->setAmountCutPackets(predLast);
-                    obj->removeFirstPackets(predLast);
+                        time = last.getOffset() - predLast.getOffset();
+                    obj->setArrivalTime(amount - 1, time);
+                    obj->setAmountCutPackets(obj->getAmountCutPackets() + uint32_t(amount - 2));
+                    obj->removeFirstPackets(amount - 2);
                     obj->setNeedCut(false);
                 }
             }
@@ -60,18 +79,16 @@ void frames::worker::Worker::frameHandle(LogFrame &frame) {
                                  frame.getOffset(),
                                  {{frame.getSize(), frame.getOffset()}});
             obj->addPacket(new_p);
-        } else {
-            uint64_t last = obj->getPackets().size() - 1;
-            obj->getPacket(last).addFragment(&frame);
-        }
-        if (obj->getPackets().size() > 2) {
-            uint32_t sz = obj->getPackets().size();
-            uint32_t l = sz - 3, m = sz - 2, r = sz - 1;
-            if (utils::checkRetransmission(obj->getPackets()[l].getSeqNum(),
-                                           obj->getPackets()[m].getSeqNum(),
-                                           obj->getPackets()[r].getSeqNum()))
-                obj->removeByIndex(m);
-        }
+        } else
+            obj->addFragment(&frame);
+        size_t sz = obj->getPacketsAmount();
+        if (sz > 2 && utils::checkRetransmission(obj->getPacket(sz - 3).getSeqNum(),
+                                                 obj->getPacket(sz - 2).getSeqNum(),
+                                                 obj->getPacket(sz - 1).getSeqNum()))
+            obj->removeByIndex(sz - 2);
+        // Packets before the tail can't change anymore
+        if (!obj->isNeedCut())
+            obj->streamFirstPackets(STREAMING_TAIL);
     }
 }
 
@@ -83,8 +100,7 @@ int frames::worker::Worker::readFramesFromStream(istream &in,
     string line;
     while (getline(in, line, '\n')) {
         // skip isPacketsEmpty string
-        smatch match;
-        if (regex_match(line, match, regex("^\\s*$"))) continue;
+        if (utils::isBlank(line)) continue;
         // remeber string
         lines[count++] = line;
         if (count == expectedCount) {
@@ -108,10 +124,28 @@ int frames::worker::Worker::readFramesFromFile(const string &path,
     return exitCode;
 }
 
-const unordered_map<uint64_t, shared_ptr<object::PacketClassifiedObject>> &frames::worker::Worker::getObjects() const {
+const vector<frames::worker::Worker::handle_t> &frames::worker::Worker::getObjects() const {
     return objects;
 }
 
+const shared_ptr<object::MacTable> &frames::worker::Worker::getMacTable() const {
+    return macs;
+}
+
+object::PacketClassifiedObject &frames::worker::Worker::getObject(handle_t handle) {
+    return pool.get(handle);
+}
+
+const object::PacketClassifiedObject &frames::worker::Worker::getObject(handle_t handle) const {
+    return pool.get(handle);
+}
+
+void frames::worker::Worker::release(id_t id) {
+    if (id >= objects.size() || objects[id] == NONE) return;
+    pool.release(objects[id]);
+    objects[id] = NONE;
+}
+
 bool frames::worker::Worker::isQueueEmpty() const {
     return queue.empty();
 }
@@ -120,14 +154,23 @@ size_t frames::worker::Worker::getQueueSize() const {
     return queue.size();
 }
 
-std::shared_ptr<object::PacketClassifiedObject> frames::worker::Worker::popFront() {
-    std::shared_ptr<object::PacketClassifiedObject> obj = queue.front();
+frames::worker::Worker::handle_t frames::worker::Worker::popFront() {
+    handle_t handle = queue.front();
     queue.pop();
-    return obj;
+    return handle;
+}
+
+void frames::worker::Worker::setStreaming(bool enable) {
+    streaming = enable;
+}
+
+bool frames::worker::Worker::isStreaming() const {
+    return streaming;
 }
 
 void frames::worker::Worker::clear() {
     while (!queue.empty())
         queue.pop();
     objects.clear();
+    pool.clear();
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <cstdint>
+#include "data.hpp"
+
+namespace mllib {
+    /**
+     * Features quantized once into at most 256 bins, column by column.
+     *
+     * Bins of feature are separated by thresholds: value lies in bin `b` if it is greater
+     * than `b` thresholds, so `x > threshold(f, b)` <=> `get_bin(row, f) > b`. Feature with
+     * not more unique values than bins keeps each value in its own bin and thresholds are
+     * midpoints between neighbouring values; otherwise bins hold about equal amount of samples.
+     */
+    class BinnedData {
+    public:
+        static const size_t MAX_BINS = 256;
+    private:
+        size_t samples_amount = 0;
+        size_t features_amount = 0;
+        /// Bins of feature `f` of sample `i` lie at `f * samples_amount + i`.
+        std::vector<uint8_t> bins;
+        /// Thresholds of all features, thresholds of feature `f` begin at `offsets[f]`.
+        std::vector<double> thresholds;
+        /// Offsets of features' thresholds, the last one is amount of all thresholds.
+        std::vector<size_t> offsets;
+    public:
+        BinnedData() = default;
+        /**
+         * Quantize features of data.
+         *
+         * @param data samples;
+         * @param max_bins maximum amount of bins of feature, from 2 to `MAX_BINS`.
+         */
+        explicit BinnedData(const Data &data, size_t max_bins = MAX_BINS);
+        size_t samples_size() const;
+        size_t features_size() const;
+        uint8_t get_bin(size_t row, size_t column) const;
+        /**
+         * Get bins of feature.
+         *
+         * @param column feature.
+         *
+         * @return bins of all samples.
+         */
+        const uint8_t *get_column(size_t column) const;
+        /**
+         * Get amount of bins of feature.
+         *
+         * @param column feature.
+         *
+         * @return amount of bins, at least 1.
+         */
+        size_t bins_size(size_t column) const;
+        /**
+         * Get threshold between bin and the next one.
+         *
+         * @param column feature;
+         * @param bin bin, less than `bins_size(column) - 1`.
+         *
+         * @return threshold.
+         */
+        double get_threshold(size_t column, size_t bin) const;
+    };
+}
@@ -3,6 +3,7 @@
 //
 #pragma once
 
+#include <cstdint>
 #include <unordered_set>
 #include <functional>
 #include "utils.hpp"
@@ -31,6 +32,15 @@ namespace mllib {
         void read_with_skip_features(const std::string &path, bool has_header = true, size_t label_idx = 0,
                                      const std::unordered_set<size_t> &skip_ids = {});
         std::vector<size_t> generate_samples(size_t cnt, std::mt19937_64 &eng) const;
+        /**
+         * Draw bootstrap sample: samples are drawn uniformly with replacement.
+         *
+         * @param cnt amount of draws;
+         * @param eng random engine.
+         *
+         * @return counts of draws of every sample.
+         */
+        std::vector<uint32_t> generate_bootstrap(size_t cnt, std::mt19937_64 &eng) const;
         std::vector<size_t> generate_balanced_samples(double part, std::mt19937_64 &eng) const;
         std::vector<size_t> get_difference(const std::vector<size_t> &ids) const;
         std::vector<size_t> generate_features(std::function<size_t(size_t)> &get_cnt, std::mt19937_64 &eng) const;
@@ -0,0 +1,149 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mllib { namespace model_file {
+    /// Version of layout, readers reject other versions.
+    const uint32_t VERSION = 1;
+    /// Alignment of every section from the beginning of file.
+    const size_t ALIGNMENT = 64;
+
+    /**
+     * Make tag of section from four characters.
+     *
+     * @param name four characters.
+     *
+     * @return tag.
+     */
+    constexpr uint32_t tag(const char (&name)[5]) {
+        return uint32_t(uint8_t(name[0])) | uint32_t(uint8_t(name[1])) << 8 |
+               uint32_t(uint8_t(name[2])) << 16 | uint32_t(uint8_t(name[3])) << 24;
+    }
+
+    /**
+     * Binary container of models.
+     *
+     * File starts with magic, version and table of sections, each section is an aligned array
+     * identified by tag and index, so models read their arrays in place without parsing.
+     * Values are stored in native byte order.
+     */
+    class writer_t {
+    private:
+        struct section_t {
+            uint32_t tag;
+            uint32_t index;
+            std::vector<char> bytes;
+        };
+        std::vector<section_t> sections;
+    public:
+        /**
+         * Add section.
+         *
+         * @param tag tag of section;
+         * @param index index among sections with the same tag;
+         * @param data bytes of section;
+         * @param size amount of bytes.
+         */
+        void add(uint32_t tag, uint32_t index, const void *data, size_t size);
+        template <typename T>
+        void add(uint32_t tag, uint32_t index, const std::vector<T> &values) {
+            add(tag, index, values.data(), values.size() * sizeof(T));
+        }
+        /**
+         * Write container into file.
+         *
+         * @param path file's path.
+         *
+         * @return false if file can't be written.
+         */
+        bool save(const std::string &path) const;
+    };
+
+    /**
+     * Read-only container mapped into memory.
+     *
+     * Arrays returned by reader point into mapping, so they live as long as reader.
+     */
+    class reader_t {
+    private:
+        struct entry_t {
+            uint32_t tag;
+            uint32_t index;
+            uint64_t offset;
+            uint64_t size;
+        };
+        const char *data = nullptr;
+        size_t size = 0;
+        /// Mapping of file, or buffer if file can't be mapped.
+        void *mapping = nullptr;
+        std::vector<char> buffer;
+        const entry_t *entries = nullptr;
+        uint32_t entries_amount = 0;
+
+        bool check();
+    public:
+        reader_t() = default;
+        reader_t(const reader_t &) = delete;
+        reader_t &operator=(const reader_t &) = delete;
+        ~reader_t();
+        /**
+         * Map file and check its header and table of sections.
+         *
+         * @param path file's path.
+         *
+         * @return false if file can't be read or isn't a valid container.
+         */
+        bool open(const std::string &path);
+        bool valid() const;
+        /**
+         * Find section.
+         *
+         * @param tag tag of section;
+         * @param index index among sections with the same tag;
+         * @param size amount of bytes of section.
+         *
+         * @return beginning of section or nullptr if there is no such section.
+         */
+        const void *get(uint32_t tag, uint32_t index, size_t &size) const;
+        /**
+         * Find section as array.
+         *
+         * @param tag tag of section;
+         * @param index index among sections with the same tag;
+         * @param amount amount of values in array.
+         *
+         * @return array or nullptr if there is no such section or its size isn't multiple of `T`.
+         */
+        template <typename T>
+        const T *get(uint32_t tag, uint32_t index, size_t &amount) const {
+            size_t bytes = 0;
+            const void *ptr = get(tag, index, bytes);
+            if (ptr == nullptr || bytes % sizeof(T) != 0) return nullptr;
+            amount = bytes / sizeof(T);
+            return static_cast<const T *>(ptr);
+        }
+        /**
+         * Copy section into vector.
+         *
+         * @param tag tag of section;
+         * @param index index among sections with the same tag;
+         * @param values output vector.
+         *
+         * @return false if there is no such section.
+         */
+        template <typename T>
+        bool read(uint32_t tag, uint32_t index, std::vector<T> &values) const {
+            size_t amount = 0;
+            const T *ptr = get<T>(tag, index, amount);
+            if (ptr == nullptr) return false;
+            values.assign(ptr, ptr + amount);
+            return true;
+        }
+    };
+} }
@@ -7,6 +7,7 @@
 #include <numeric>
 #include "utils.hpp"
 #include "matrix.hpp"
+#include "model_file.hpp"
 
 namespace mllib { namespace models {
     class probability_model_t {
@@ -16,13 +17,51 @@ namespace mllib { namespace models {
         std::vector<double> p;
         Matrix<double> a;
         Matrix<double> b;
+        /**
+         * Make forward variables of sequence extended by observation.
+         *
+         * @param alpha forward variables of sequence, empty for empty one;
+         * @param o observation;
+         * @param next forward variables of extended sequence.
+         */
+        void forward_step(const std::vector<double> &alpha, size_t o, std::vector<double> &next) const;
 //        void baum_welch(const std::vector<std::vector<size_t>> &O);
     public:
         explicit probability_model_t(size_t states_amount = 0, size_t observations_amount = 0);
         void save(const std::string &path) const;
         void load(const std::string &path);
+        /**
+         * Add model into binary container.
+         *
+         * @param writer container.
+         */
+        void save_binary(model_file::writer_t &writer) const;
+        /**
+         * Copy model from binary container.
+         *
+         * @param reader container.
+         *
+         * @return false if container has no valid model, the model is unchanged then.
+         */
+        bool load_binary(const model_file::reader_t &reader);
         void fit(const std::vector<std::vector<size_t>> &O, const std::vector<std::vector<size_t>> &S);
         size_t predict_state(const std::vector<size_t> &O) const;
+        /**
+         * Extend sequence by observation, its state is kept in forward variables instead of observations.
+         * Variables aren't normalized, so `predict_last_state` equals `predict_state` of the whole sequence.
+         *
+         * @param alpha forward variables of sequence, empty for empty one; they are replaced;
+         * @param o observation.
+         */
+        void forward(std::vector<double> &alpha, size_t o) const;
+        /**
+         * Predict state of the last observation of sequence by its forward variables.
+         *
+         * @param alpha forward variables of non-empty sequence.
+         *
+         * @return the same state as `predict_state` of the sequence.
+         */
+        size_t predict_last_state(const std::vector<double> &alpha) const;
 //        std::vector<double> predict_states(const std::vector<size_t> &O) const;
     };
 } }
\ No newline at end of file
@@ -4,9 +4,15 @@
 #pragma once
 
 #include <set>
+#include <stack>
 #include <climits>
+#include <iomanip>
+#include <memory>
 #include "estimator.hpp"
 #include "thread_pool.hpp"
+#include "model_file.hpp"
+#include "binned_data.hpp"
+#include "sorted_data.hpp"
 
 namespace mllib { namespace calculation {
     size_t _sqrt(size_t x);
@@ -19,6 +25,80 @@ namespace mllib { namespace calculation {
     double compute_IG(std::map<size_t, size_t> &left, std::map<size_t, size_t> &right);
     double compute_entropy(std::map<size_t, size_t> &labels);
     std::map<size_t, double> compute_probabilities(std::map<size_t, size_t> &labels);
+    /**
+     * Convert split threshold for single-precision queries.
+     *
+     * @param threshold threshold of split.
+     *
+     * @return the greatest float not greater than `threshold`, so x > threshold <=> x > result for any float x.
+     */
+    float quantize_threshold(double threshold);
+
+    /**
+     * Label counts on both sides of split, labels are dense ids `0..k-1`.
+     * Sums of squared counts are kept up to date for gini.
+     */
+    struct split_counts_t {
+        std::vector<size_t> left;
+        std::vector<size_t> right;
+        size_t n_left = 0;
+        size_t n_right = 0;
+        size_t left_squares = 0;
+        size_t right_squares = 0;
+
+        /**
+         * Put all samples to the right side.
+         *
+         * @param labels counts of dense labels.
+         */
+        explicit split_counts_t(const std::vector<size_t> &labels);
+        /**
+         * Move samples from the right side to the left one.
+         *
+         * @param label dense label of samples;
+         * @param amount amount of samples.
+         */
+        void move_left(size_t label, size_t amount = 1) {
+            left_squares += (2 * left[label] + amount) * amount;
+            right_squares -= (2 * right[label] - amount) * amount;
+            left[label] += amount;
+            right[label] -= amount;
+            n_left += amount;
+            n_right -= amount;
+        }
+    };
+
+    /// Weighted gini impurity of split, the same as `compute_gini`.
+    struct gini_criterion_t {
+        static const bool lower_better = true;
+
+        explicit gini_criterion_t(const std::vector<size_t> &/*labels*/) {}
+        double score(const split_counts_t &counts) const;
+    };
+
+    /// Information gain of split, the same as `compute_IG`.
+    struct entropy_criterion_t {
+        static const bool lower_better = false;
+        /// Entropy of node, it doesn't depend on split.
+        double h_parent;
+
+        explicit entropy_criterion_t(const std::vector<size_t> &labels);
+        double score(const split_counts_t &counts) const;
+    };
+
+    /**
+     * Compare score of split with the best one, ties go to the later split.
+     *
+     * @tparam Criterion criterion of split.
+     * @param value score of split;
+     * @param best the best score.
+     *
+     * @return true if split is not worse.
+     */
+    template <class Criterion>
+    bool is_not_worse(double value, double best) {
+        return (Criterion::lower_better && value <= best) || (!Criterion::lower_better && value >= best);
+    }
 } }
 
 namespace mllib { namespace models {
@@ -39,7 +119,30 @@ namespace mllib { namespace models {
             ~node();
             node& operator=(node &&n) noexcept;
             std::string node_def(size_t cur_id);
-            std::tuple<size_t, size_t, size_t> parse(const std::vector<std::string> &lines);
+            /**
+             * Parse node from its two lines of text format.
+             *
+             * @return ids of node and its children.
+             */
+            std::tuple<size_t, size_t, size_t> parse(const char *first, const char *first_end,
+                                                     const char *second, const char *second_end);
+        };
+        /// Nodes with at least so many samples give children their own random engines
+        /// and build children and features in parallel when fit has task pool.
+        static const size_t PARALLEL_NODE_SIZE = 8192;
+        /// Node of compiled tree, nodes are stored in breadth-first order.
+        struct flat_node {
+            double threshold = 0.0;
+            /// Index of feature, or index of leaf in leaf table for leaves.
+            uint32_t feature_idx = 0;
+            /// Index of left child, the right one follows it; 0 for leaves.
+            uint32_t left = 0;
+        };
+        /// The same node for single-precision queries, nodes of both kinds have the same indices.
+        struct flat_node_f {
+            float threshold = 0.0f;
+            uint32_t feature_idx = 0;
+            uint32_t left = 0;
         };
 
         bool lower_better;
@@ -47,56 +150,269 @@ namespace mllib { namespace models {
         size_t min_samples_leaf;
         size_t min_samples_split;
         size_t seed;
+        /// Amount of bins of features for histogram training, 0 for exact splits.
+        size_t max_bins = 0;
         std::mt19937_64 eng;
         std::string criterion_func_name;
         std::string max_feature_func_name;
         std::function<size_t(size_t)> get_feature_amount;
         std::function<double(std::map<size_t, size_t> &)> node_value_func;
-        std::function<double(std::map<size_t, size_t> &, std::map<size_t, size_t> &)> criterion_func;
         node *root = nullptr;
+        // dense ids of training samples' labels, they exist only during fit
+        std::vector<uint32_t> dense_targets;
+        /// Counts of training samples in bootstrap, by sample index.
+        std::vector<uint32_t> sample_weights;
+        std::vector<size_t> dense_labels;
+        size_t dense_classes_amount = 0;
+        /// Pool of fit, nullptr for sequential fit.
+        TaskPool *task_pool = nullptr;
+        /// Training samples sorted by every feature once per tree, they exist only during exact fit.
+        struct presorted_t {
+            /// Segment `f` of `samples_amount` ids is sorted by feature `f`, node owns the same range of every segment.
+            std::vector<uint32_t> order;
+            /// Values of feature `f` of samples in segment `f`, they move together with ids.
+            std::vector<double> values;
+            size_t samples_amount = 0;
+            /// Right part of range being partitioned.
+            std::vector<uint32_t> buffer;
+            std::vector<double> values_buffer;
+            /// Marks of samples going to the right child, by sample index.
+            std::vector<uint8_t> goes_right;
+        } presorted;
+        /// Offsets of features in histogram: bin `b` of feature `f` holds labels' counts at `offset[f] + b * classes`.
+        std::vector<size_t> histogram_offsets;
+        // compiled tree for inference, it is built after fit and load
+        std::vector<flat_node> flat_nodes;
+        std::vector<flat_node_f> flat_nodes_f;
+        /// Labels which leaves predict.
+        std::vector<size_t> leaf_labels;
+        /// Labels of all leaves, columns of `leaf_probabilities`.
+        std::vector<size_t> classes;
+        /// Probabilities of `classes`, row per leaf.
+        std::vector<double> leaf_probabilities;
+        /// Compiled tree in use, it points to arrays above or into mapped model file.
+        struct compiled_t {
+            const flat_node *nodes = nullptr;
+            const flat_node_f *nodes_f = nullptr;
+            const size_t *leaf_labels = nullptr;
+            const size_t *classes = nullptr;
+            const double *leaf_probabilities = nullptr;
+            size_t nodes_amount = 0;
+            size_t leaves_amount = 0;
+            size_t classes_amount = 0;
+        } compiled;
 
-        static void split_samples_by_threshold(size_t &feature_idx,
-                                               double &threshold,
-                                               std::vector<size_t> &samples,
-                                               std::vector<size_t> &left,
-                                               std::vector<size_t> &right,
-                                               Data &data);
+        /**
+         * Find the best split among exact thresholds of random features.
+         *
+         * @param node node, its feature and threshold are set;
+         * @param begin beginning of node's range of presorted samples;
+         * @param end end of node's range of presorted samples;
+         * @param labels counts of dense labels of node;
+         * @param data samples;
+         * @param engine random engine of node.
+         */
+        template <class Criterion>
         void choose_best_split(node *node,
-                               std::vector<size_t> &samples,
-                               Data &data);
+                               size_t begin,
+                               size_t end,
+                               const std::vector<size_t> &labels,
+                               Data &data,
+                               std::mt19937_64 &engine);
+        /**
+         * Stably partition node's range of every presorted feature.
+         *
+         * @param begin beginning of node's range;
+         * @param middle end of the left part of range in order of split feature;
+         * @param end end of node's range;
+         * @param feature_idx split feature.
+         */
+        void partition_samples(size_t begin, size_t middle, size_t end, size_t feature_idx);
+        node *construct_node(size_t depth,
+                             size_t begin,
+                             size_t end,
+                             Data &data,
+                             std::mt19937_64 &engine);
+        /**
+         * Call function for indices from 0 to amount, in parallel if fit has task pool.
+         *
+         * @param amount amount of indices;
+         * @param parallel false to call function sequentially anyway;
+         * @param function function of index.
+         */
+        template <class Function>
+        void for_each_index(size_t amount, bool parallel, Function function) const;
+        void init_presorted(const SortedData &sorted);
+        void init_sample_weights(const Data &data, const std::vector<uint32_t> &weights);
+        void init_dense_targets(const Data &data);
+        void clear_dense_targets();
+        void build_histogram(const std::vector<size_t> &samples,
+                             const BinnedData &binned,
+                             std::vector<uint32_t> &histogram) const;
+        /**
+         * Find the best split among bins of random features.
+         *
+         * @param node node, its feature and threshold are set;
+         * @param samples samples of node;
+         * @param labels counts of dense labels of node;
+         * @param histogram counts of labels in bins of node, empty for small node;
+         * @param data samples;
+         * @param binned bins of samples;
+         * @param engine random engine of node;
+         * @param best_bin samples with greater bin go to the right.
+         *
+         * @return false if all chosen features are constant in node.
+         */
+        template <class Criterion>
+        bool choose_best_bin(node *node,
+                             const std::vector<size_t> &samples,
+                             const std::vector<size_t> &labels,
+                             const std::vector<uint32_t> &histogram,
+                             Data &data,
+                             const BinnedData &binned,
+                             std::mt19937_64 &engine,
+                             size_t &best_bin);
         node *construct_node(size_t depth,
                              std::vector<size_t> &samples,
-                             Data &data);
-        std::map<size_t, double> get_probabilities(const std::vector<double> &query) const;
-        std::map<size_t, double> get_probabilities(size_t sample_idx, Data &data) const;
+                             Data &data,
+                             const BinnedData &binned,
+                             std::vector<uint32_t> &histogram,
+                             std::mt19937_64 &engine);
+        /// Build compiled tree from nodes.
+        void compile();
+        size_t find_leaf(const double *query) const;
+        size_t find_leaf(const float *query) const;
+        size_t find_leaf(size_t sample_idx, const Data &data) const;
         void generate_definition_for_graphviz(node *node, size_t id, size_t parent_id, std::ostream &out);
+        void generate_node_code(uint32_t id, size_t depth, const std::vector<size_t> &labels, std::ostream &out) const;
         void get_tree_def(node *node, size_t id, std::queue<std::string> &queue);
-        size_t parse_header(const std::string &header);
+        size_t parse_header(const char *begin, const char *end);
     public:
         explicit DecisionTree(size_t max_depth = 0,
                               size_t min_samples_leaf = 1,
                               size_t min_samples_split = 2,
                               const std::string &criterion = "gini",
                               const std::string &max_features = "none",
-                              size_t seed = 0);
+                              size_t seed = 0,
+                              size_t max_bins = 0);
         DecisionTree(DecisionTree &&m) noexcept;
         ~DecisionTree();
         DecisionTree& operator=(DecisionTree &&m) noexcept;
         std::string get_saved_def();
         void save(const std::string &path, std::ios_base::openmode mode = std::ios::out) override;
+        /**
+         * Build tree from its text definition: header line and two lines per node.
+         *
+         * @param begin beginning of definition;
+         * @param end end of definition, text must be terminated by zero after it or by line break.
+         */
+        void parse(const char *begin, const char *end);
         void load_from_stream(std::istream &in);
         void load(const std::string &path) override;
+        /**
+         * Add compiled tree into binary container.
+         *
+         * @param writer container;
+         * @param index index of tree in container.
+         */
+        void save_binary(model_file::writer_t &writer, uint32_t index) const;
+        /**
+         * Use compiled tree from binary container in place.
+         * Such tree only predicts, its text definition and drawing are empty.
+         *
+         * @param reader container, it must outlive the tree;
+         * @param index index of tree in container.
+         *
+         * @return false if container has no valid tree with this index.
+         */
+        bool load_binary(const model_file::reader_t &reader, uint32_t index);
         DecisionTree *clone() override;
         void fit(Data &data) override;
+        /**
+         * Fit tree on histograms of quantized features.
+         *
+         * @param data samples;
+         * @param binned bins of the same samples, they may be shared by trees;
+         * @param weights counts of samples in bootstrap, empty to take every sample once;
+         * @param pool pool which builds large nodes in parallel, nullptr for sequential fit.
+         */
+        void fit(Data &data, const BinnedData &binned,
+                 const std::vector<uint32_t> &weights = {}, TaskPool *pool = nullptr);
+        /**
+         * Fit tree with exact splits on presorted features.
+         *
+         * @param data samples;
+         * @param sorted the same samples sorted by features, they may be shared by trees;
+         * @param weights counts of samples in bootstrap, empty to take every sample once;
+         * @param pool pool which builds large nodes in parallel, nullptr for sequential fit.
+         */
+        void fit(Data &data, const SortedData &sorted,
+                 const std::vector<uint32_t> &weights = {}, TaskPool *pool = nullptr);
+        /**
+         * Draw bootstrap sample with random engine of tree.
+         *
+         * @param data samples;
+         * @param amount amount of draws with replacement.
+         *
+         * @return counts of samples, they are weights for fit.
+         */
+        std::vector<uint32_t> draw_bootstrap(const Data &data, size_t amount);
         void predict(Data &queries, std::vector<size_t> &result) override;
         size_t predict(const std::vector<double> &query) override;
+        /**
+         * Predict label of single-precision query.
+         *
+         * @param query features.
+         *
+         * @return label.
+         */
+        size_t predict(const std::vector<float> &query) const;
+        /**
+         * Predict label of one sample of data.
+         *
+         * @param sample_idx index of sample;
+         * @param data samples.
+         *
+         * @return label.
+         */
+        size_t predict(size_t sample_idx, const Data &data) const;
+        /**
+         * Predict labels of single-precision queries.
+         *
+         * @param queries row-major matrix of features;
+         * @param result labels, its size is amount of queries.
+         */
+        void predict(const Matrix<float> &queries, std::vector<size_t> &result) const;
         void predict_prob(Data &queries, std::vector<std::map<size_t, double>> &probabilities) override;
         bool valid() const override;
         void draw(const std::string &path);
+        /**
+         * Get labels which tree can predict.
+         *
+         * @return sorted labels of leaves.
+         */
+        std::vector<size_t> get_labels() const;
+        /**
+         * Write tree as C++ function `size_t name(const float *x)` with nested if/else.
+         *
+         * @param out output stream;
+         * @param name name of function;
+         * @param labels sorted labels, function returns index of predicted label among them.
+         */
+        void generate_code(std::ostream &out, const std::string &name, const std::vector<size_t> &labels) const;
         size_t get_seed() const;
+        /**
+         * Get amount of features which queries must have.
+         *
+         * @return 1 + the greatest index of feature used in splits, 0 for tree without splits.
+         */
+        size_t get_features_amount() const;
     };
 
     class RandomForest : public Estimator {
+    public:
+        /// Predictions with less queries to all trees together are done on calling thread.
+        static const size_t INLINE_QUERIES = 4096;
     private:
         size_t n_estimators;
         size_t n_jobs;
@@ -105,11 +421,48 @@ namespace mllib { namespace models {
         size_t min_samples_split;
         std::string criterion;
         std::string max_features;
+        /// Amount of bins of features for histogram training, 0 for exact splits.
+        size_t max_bins;
+        /// Bootstrap of each tree draws `max_samples` of all samples with replacement, it lies in (0, 1].
+        double max_samples;
+        /// Seed of forest, seeds of trees are drawn from it; 0 in constructor means random one.
+        size_t seed;
+        /// Accuracy of votes of trees for samples out of their bootstraps.
+        double oob_score = 0.0;
+        /// Amount of features of training data, 0 for forests saved before it was recorded.
+        size_t n_features = 0;
+        /// Identifier of features of training data set by their owner, 0 if it is unknown.
+        uint64_t schema = 0;
         std::vector<DecisionTree> trees;
-        std::size_t *seeds = nullptr;
+        /// Sorted labels of leaves of all trees, votes are counted in their order.
+        std::vector<size_t> class_labels;
+        /// Container which trees loaded in place point to.
+        std::shared_ptr<const model_file::reader_t> mapped;
+        /// Threads of fit and prediction, they live as long as forest; nullptr for one job.
+        std::shared_ptr<TaskPool> pool;
 
         void norm(std::map<size_t, double> &result) const;
-        void parse_header(const std::string &header);
+        /// Start own pool of `n_jobs` threads.
+        void reset_pool();
+        /**
+         * Call job for every tree, on calling thread if there is no pool or work is small.
+         *
+         * @param queries amount of queries of every tree;
+         * @param job function of tree's index.
+         */
+        void for_each_tree(size_t queries, const std::function<void(size_t)> &job) const;
+        void parse_header(const char *begin, const char *end);
+        /// Collect `class_labels` from trees.
+        void init_labels();
+        /**
+         * Count votes of trees into flat array, without allocation for few labels.
+         *
+         * @param tree_label function of tree's index, label predicted by tree.
+         *
+         * @return label with the most votes, the least one on ties; 0 for forest without trees.
+         */
+        template <class TreeLabel>
+        size_t vote(const TreeLabel &tree_label) const;
     public:
         explicit RandomForest(size_t n_estimators = 10,
                      size_t n_jobs = 1,
@@ -117,19 +470,91 @@ namespace mllib { namespace models {
                      size_t min_samples_leaf = 1,
                      size_t min_samples_split = 2,
                      const std::string &criterion = "gini",
-                     const std::string &max_features = "none");
+                     const std::string &max_features = "none",
+                     size_t max_bins = 0,
+                     double max_samples = 1.0,
+                     size_t seed = 0);
         RandomForest(RandomForest &&m) noexcept;
-        ~RandomForest();
         RandomForest& operator=(RandomForest &&m) noexcept;
         std::string get_saved_def();
         void save(const std::string &path, std::ios_base::openmode mode = std::ios::out) override;
+        /**
+         * Load forest from the rest of stream: trees are found by blank lines in one scan
+         * and parsed in parallel by `n_jobs` threads.
+         *
+         * @param in stream with text definition of forest.
+         */
         void load_from_stream(std::istream &in);
         void load(const std::string &path) override;
+        /**
+         * Add forest into binary container.
+         *
+         * @param writer container.
+         */
+        void save_binary(model_file::writer_t &writer) const;
+        /**
+         * Use forest from binary container in place.
+         *
+         * @param reader container, forest keeps it.
+         *
+         * @return false if container has no valid forest, the forest is unchanged then.
+         */
+        bool load_binary(std::shared_ptr<const model_file::reader_t> reader);
         RandomForest *clone() override;
+        /**
+         * Use another pool, e.g. one shared by several models. Loading forest with
+         * amount of jobs starts its own pool again.
+         *
+         * @param other pool, nullptr to fit and predict on calling thread.
+         */
+        void set_pool(std::shared_ptr<TaskPool> other);
         void fit(Data &data) override;
         void predict(Data &queries, std::vector<size_t> &result) override;
         size_t predict(const std::vector<double> &query) override;
+        size_t predict(const std::vector<float> &query);
+        /**
+         * Predict labels of single-precision queries.
+         *
+         * @param queries row-major matrix of features;
+         * @param result labels, its size is amount of queries.
+         */
+        void predict(const Matrix<float> &queries, std::vector<size_t> &result);
         void predict_prob(Data &queries, std::vector<std::map<size_t, double>> &probabilities) override;
         bool valid() const override;
+        /**
+         * Get amount of features which forest was trained on, queries must have exactly so many features.
+         *
+         * @return amount of features of training data; for forests saved without it
+         * 1 + the greatest index of feature used in splits.
+         */
+        size_t get_features_amount() const;
+        /**
+         * Set identifier of features which forest is trained on, it is saved with forest.
+         *
+         * @param id identifier of features' list and order, 0 if it is unknown.
+         */
+        void set_schema(uint64_t id);
+        /**
+         * Get identifier of features which forest was trained on.
+         *
+         * @return identifier set before saving, 0 for forests saved without it.
+         */
+        uint64_t get_schema() const;
+        /**
+         * Get out-of-bag accuracy of the last fit: every sample is predicted by majority
+         * of trees which didn't draw it, samples drawn by all trees are skipped.
+         *
+         * @return accuracy, 0 if no sample was out of bag.
+         */
+        double get_oob_score() const;
+        /**
+         * Write forest as C++ translation unit with function `size_t name(const float *x)`,
+         * it predicts the same labels as `predict(const std::vector<float> &)`.
+         *
+         * @param out output stream;
+         * @param name name of prediction function.
+         */
+        void generate_code(std::ostream &out, const std::string &name = "predict") const;
+        void generate_code(const std::string &path, const std::string &name = "predict") const;
     };
 } }
\ No newline at end of file
@@ -0,0 +1,51 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+#pragma once
+
+#include <cstdint>
+#include "data.hpp"
+
+namespace mllib {
+    /**
+     * Samples sorted by every feature once, column by column.
+     *
+     * Column `f` holds ids of all samples in ascending order of feature `f` together with
+     * their values, so trees fitted on subsets of samples take their order without sorting.
+     */
+    class SortedData {
+    private:
+        size_t samples_amount = 0;
+        size_t features_amount = 0;
+        /// Ids of column `f` lie at `f * samples_amount`.
+        std::vector<uint32_t> order;
+        /// Values of feature `f` in order of column `f`.
+        std::vector<double> values;
+    public:
+        SortedData() = default;
+        /**
+         * Sort samples by each feature.
+         *
+         * @param data samples.
+         */
+        explicit SortedData(const Data &data);
+        size_t samples_size() const;
+        size_t features_size() const;
+        /**
+         * Get samples sorted by feature.
+         *
+         * @param column feature.
+         *
+         * @return ids of all samples.
+         */
+        const uint32_t *get_order(size_t column) const;
+        /**
+         * Get sorted values of feature.
+         *
+         * @param column feature.
+         *
+         * @return values of samples in order of `get_order(column)`.
+         */
+        const double *get_values(size_t column) const;
+    };
+}
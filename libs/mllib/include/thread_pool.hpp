@@ -3,6 +3,9 @@
 //
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -27,4 +30,62 @@ namespace mllib {
         ~ThreadPool();
         void add_job(job _job);
     };
+
+    /**
+     * Work-stealing pool for nested fork-join tasks.
+     *
+     * Every worker takes the newest tasks of its own deque and steals the oldest ones of
+     * others when it runs out of work. Thread which waits for group executes tasks meanwhile,
+     * so tasks may spawn tasks and wait for them; it works as one of pool's threads.
+     */
+    class TaskPool {
+    public:
+        typedef std::function<void(void)> job;
+        /// Tasks awaited together.
+        class group_t {
+            friend class TaskPool;
+            std::atomic<size_t> _pending{0};
+        };
+    protected:
+        struct queue_t {
+            std::mutex lock;
+            std::deque<std::pair<job, group_t *>> tasks;
+        };
+
+        std::atomic<bool> _shutdown{false};
+        std::atomic<size_t> _queued{0};
+        std::mutex _lock;
+        std::condition_variable _cond_var;
+        /// Deques of workers, the last one is shared by other threads.
+        std::vector<std::unique_ptr<queue_t>> _queues;
+        std::vector<std::thread> _threads;
+
+        size_t own_queue() const;
+        bool run_one(size_t queue_id);
+        void thread_work(size_t id);
+    public:
+        /**
+         * Start pool.
+         *
+         * @param threads_cnt amount of threads including waiting one, so `threads_cnt - 1` workers are started.
+         */
+        explicit TaskPool(int threads_cnt);
+        TaskPool(const TaskPool &) = delete;
+        TaskPool &operator=(const TaskPool &) = delete;
+        ~TaskPool();
+        size_t size() const;
+        /**
+         * Add task into group.
+         *
+         * @param group group of task, it must be awaited;
+         * @param _job task.
+         */
+        void run(group_t &group, job _job);
+        /**
+         * Execute tasks until all tasks of group are done.
+         *
+         * @param group group to wait for.
+         */
+        void wait(group_t &group);
+    };
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/binned_data.hpp"
+
+using namespace std;
+
+mllib::BinnedData::BinnedData(const Data &data, size_t max_bins) :
+samples_amount(data.samples_size()),
+features_amount(data.features_size())
+{
+    max_bins = max(size_t(2), min(max_bins, size_t(MAX_BINS)));
+    bins.resize(samples_amount * features_amount);
+    offsets.reserve(features_amount + 1);
+    offsets.push_back(0);
+    vector<double> values(samples_amount);
+    for (size_t f = 0; f < features_amount; f++) {
+        for (size_t i = 0; i < samples_amount; i++)
+            values[i] = data.get_feature(i, f);
+        vector<double> sorted = values;
+        sort(sorted.begin(), sorted.end());
+        vector<double> unique_values = sorted;
+        unique_values.erase(unique(unique_values.begin(), unique_values.end()), unique_values.end());
+        size_t begin = thresholds.size();
+        if (unique_values.size() <= max_bins) {
+            for (size_t j = 0; j + 1 < unique_values.size(); j++)
+                thresholds.push_back((unique_values[j] + unique_values[j + 1]) / 2.0);
+        } else {
+            // cut at quantiles, between the quantile value and the previous unique one
+            for (size_t k = 1; k < max_bins; k++) {
+                double upper = sorted[k * samples_amount / max_bins];
+                auto it = lower_bound(unique_values.begin(), unique_values.end(), upper);
+                if (it == unique_values.begin()) continue;
+                double threshold = (*prev(it) + upper) / 2.0;
+                if (thresholds.size() == begin || thresholds.back() < threshold)
+                    thresholds.push_back(threshold);
+            }
+        }
+        offsets.push_back(thresholds.size());
+        auto first = thresholds.begin() + long(begin), last = thresholds.end();
+        uint8_t *column = bins.data() + f * samples_amount;
+        for (size_t i = 0; i < samples_amount; i++)
+            column[i] = uint8_t(lower_bound(first, last, values[i]) - first);
+    }
+}
+
+size_t mllib::BinnedData::samples_size() const {
+    return samples_amount;
+}
+
+size_t mllib::BinnedData::features_size() const {
+    return features_amount;
+}
+
+uint8_t mllib::BinnedData::get_bin(size_t row, size_t column) const {
+    return bins[column * samples_amount + row];
+}
+
+const uint8_t *mllib::BinnedData::get_column(size_t column) const {
+    return bins.data() + column * samples_amount;
+}
+
+size_t mllib::BinnedData::bins_size(size_t column) const {
+    return offsets[column + 1] - offsets[column] + 1;
+}
+
+double mllib::BinnedData::get_threshold(size_t column, size_t bin) const {
+    return thresholds[offsets[column] + bin];
+}
@@ -20,8 +20,8 @@ void mllib::cross_validation::split(const vector<size_t> &base,
 tuple<double, mllib::models::Estimator *> mllib::cross_validation::get_best_model_after_cross_val_score(
         models::Estimator &estimator, Data &data,
         const string& scoring, size_t cv, size_t n_jobs) {
-    vector<double> results;
-    results.reserve(cv);
+    // every fold writes its own score, the best model is chosen after all folds
+    vector<double> results(cv, 0.0);
     vector<size_t> samples;
     size_t n = data.samples_size();
     random_device rd;
@@ -32,8 +32,6 @@ tuple<double, mllib::models::Estimator *> mllib::cross_validation::get_best_mode
     vector<models::Estimator *> models(cv);
     for (auto &x : models)
         x = estimator.clone();
-    double best_score = 0.0;
-    models::Estimator *res = nullptr;
     {
         ThreadPool pool(n_jobs);
         for (size_t i = 0; i < cv; i++) {
@@ -61,14 +59,17 @@ tuple<double, mllib::models::Estimator *> mllib::cross_validation::get_best_mode
                     score = metrics::f1_score(y_true, y_pred, true);
                 else
                     score = metrics::f1_score(y_true, y_pred);
-                results.emplace_back(score);
-                if (score > best_score) {
-                    best_score = score;
-                    res = std::move(models[i]);
-                }
+                results[i] = score;
             });
         }
     }
+    double best_score = 0.0;
+    models::Estimator *res = nullptr;
+    for (size_t i = 0; i < cv; i++)
+        if (results[i] > best_score) {
+            best_score = results[i];
+            res = models[i];
+        }
 
     double sum = accumulate(results.begin(), results.end(), 0.0);
     return {sum / double(cv), std::move(res)};
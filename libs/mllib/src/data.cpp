@@ -6,6 +6,21 @@
 
 using namespace std;
 
+namespace {
+    /// Take `cnt` random ids from 0 to `n` without repetitions by partial Fisher-Yates shuffle.
+    vector<size_t> choose_without_repetitions(size_t n, size_t cnt, mt19937_64 &eng) {
+        vector<size_t> ids(n);
+        for (size_t i = 0; i < n; i++)
+            ids[i] = i;
+        cnt = min(cnt, n);
+        uniform_int_distribution<size_t> distribution;
+        for (size_t i = 0; i < cnt; i++)
+            swap(ids[i], ids[i + distribution(eng) % (n - i)]);
+        ids.resize(cnt);
+        return ids;
+    }
+}
+
 mllib::Data::Data() {
     this->samples_amount = 0;
     this->features_amount = 0;
@@ -116,14 +131,16 @@ void mllib::Data::read_with_skip_features(const string &path, bool has_header, s
 }
 
 vector<size_t> mllib::Data::generate_samples(size_t cnt, mt19937_64 &eng) const {
-    unordered_set<size_t> tmp;
-    uniform_int_distribution<size_t> distribution;
-    while (cnt > 0) {
-        size_t x = distribution(eng) % samples_amount;
-        auto res = tmp.insert(x);
-        if (res.second) cnt--;
-    }
-    return {tmp.begin(), tmp.end()};
+    return choose_without_repetitions(samples_amount, cnt, eng);
+}
+
+vector<uint32_t> mllib::Data::generate_bootstrap(size_t cnt, mt19937_64 &eng) const {
+    vector<uint32_t> counts(samples_amount, 0);
+    if (samples_amount == 0) return counts;
+    uniform_int_distribution<size_t> distribution(0, samples_amount - 1);
+    for (size_t i = 0; i < cnt; i++)
+        counts[distribution(eng)]++;
+    return counts;
 }
 
 vector<size_t> mllib::Data::generate_balanced_samples(double part, mt19937_64 &eng) const {
@@ -162,15 +179,7 @@ vector<size_t> mllib::Data::get_difference(const vector<size_t> &ids) const {
 }
 
 vector<size_t> mllib::Data::generate_features(function<size_t(size_t)> &get_cnt, mt19937_64 &eng) const {
-    size_t cnt = get_cnt(features_amount);
-    unordered_set<size_t> tmp;
-    uniform_int_distribution<size_t> distribution;
-    while (cnt > 0) {
-        size_t x = distribution(eng) % features_amount;
-        auto res = tmp.insert(x);
-        if (res.second) cnt--;
-    }
-    return {tmp.begin(), tmp.end()};
+    return choose_without_repetitions(features_amount, get_cnt(features_amount), eng);
 }
 
 string mllib::Data::features_to_string() {
@@ -0,0 +1,133 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include <fstream>
+
+#include "../include/model_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MODEL_FILE_MMAP
+#endif
+
+using namespace std;
+
+namespace {
+    const char MAGIC[8] = {'K', 'O', 'R', 'S', 'M', 'D', 'L', '\0'};
+    /// Magic, version and amount of sections.
+    const size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+    const size_t ENTRY_SIZE = 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+    size_t align(size_t offset) {
+        return (offset + mllib::model_file::ALIGNMENT - 1) / mllib::model_file::ALIGNMENT * mllib::model_file::ALIGNMENT;
+    }
+}
+
+void mllib::model_file::writer_t::add(uint32_t tag, uint32_t index, const void *data, size_t size) {
+    const char *begin = static_cast<const char *>(data);
+    sections.push_back({tag, index, vector<char>(begin, begin + size)});
+}
+
+bool mllib::model_file::writer_t::save(const string &path) const {
+    ofstream out(path, ios::out | ios::binary);
+    if (!out.is_open()) return false;
+    auto amount = uint32_t(sections.size());
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+    out.write(reinterpret_cast<const char *>(&amount), sizeof(amount));
+    // table of sections, data of sections follows it
+    size_t offset = align(HEADER_SIZE + ENTRY_SIZE * sections.size());
+    for (const auto &section : sections) {
+        auto pos = uint64_t(offset), size = uint64_t(section.bytes.size());
+        out.write(reinterpret_cast<const char *>(&section.tag), sizeof(section.tag));
+        out.write(reinterpret_cast<const char *>(&section.index), sizeof(section.index));
+        out.write(reinterpret_cast<const char *>(&pos), sizeof(pos));
+        out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        offset = align(offset + section.bytes.size());
+    }
+    const vector<char> padding(ALIGNMENT, 0);
+    size_t written = HEADER_SIZE + ENTRY_SIZE * sections.size();
+    for (const auto &section : sections) {
+        out.write(padding.data(), streamsize(align(written) - written));
+        written = align(written);
+        out.write(section.bytes.data(), streamsize(section.bytes.size()));
+        written += section.bytes.size();
+    }
+    bool ok = out.good();
+    out.close();
+    return ok;
+}
+
+mllib::model_file::reader_t::~reader_t() {
+#ifdef MODEL_FILE_MMAP
+    if (mapping != nullptr)
+        munmap(mapping, size);
+#endif
+}
+
+bool mllib::model_file::reader_t::open(const string &path) {
+    if (data != nullptr) return false;
+#ifdef MODEL_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st = {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            mapping = ptr;
+            data = static_cast<const char *>(ptr);
+            size = size_t(st.st_size);
+        }
+    }
+    close(fd);
+#endif
+    if (data == nullptr) {
+        // file is read into buffer where it can't be mapped
+        ifstream in(path, ios::in | ios::binary);
+        if (!in.is_open()) return false;
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        in.close();
+        data = buffer.data();
+        size = buffer.size();
+    }
+    if (!check()) {
+        entries = nullptr;
+        entries_amount = 0;
+        return false;
+    }
+    return true;
+}
+
+bool mllib::model_file::reader_t::check() {
+    if (data == nullptr || size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    uint32_t version, amount;
+    memcpy(&version, data + sizeof(MAGIC), sizeof(version));
+    memcpy(&amount, data + sizeof(MAGIC) + sizeof(version), sizeof(amount));
+    if (version != VERSION || (size - HEADER_SIZE) / ENTRY_SIZE < amount)
+        return false;
+    static_assert(sizeof(entry_t) == ENTRY_SIZE, "Entry of table must have no padding");
+    entries = reinterpret_cast<const entry_t *>(data + HEADER_SIZE);
+    entries_amount = amount;
+    for (uint32_t i = 0; i < entries_amount; i++)
+        if (entries[i].offset % ALIGNMENT != 0 || entries[i].offset > size || entries[i].size > size - entries[i].offset)
+            return false;
+    return true;
+}
+
+bool mllib::model_file::reader_t::valid() const {
+    return entries != nullptr;
+}
+
+const void *mllib::model_file::reader_t::get(uint32_t tag, uint32_t index, size_t &size) const {
+    for (uint32_t i = 0; i < entries_amount; i++)
+        if (entries[i].tag == tag && entries[i].index == index) {
+            size = size_t(entries[i].size);
+            return data + entries[i].offset;
+        }
+    return nullptr;
+}
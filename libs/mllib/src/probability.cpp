@@ -41,32 +41,44 @@ void models::probability_model_t::fit(const std::vector<std::vector<size_t>> &O,
         for (size_t k = 0; k < observations_amount; k++)
             b(i, k) /= y[i] > 0 ? y[i] : 1;
 }
-// TODO: Need optimisation, Need special double for extra low exponent
-size_t models::probability_model_t::predict_state(const vector<size_t> &O) const {
-    size_t T = O.size();
-    vector<vector<double>> alpha(T, vector<double>(states_amount, 0)),
-    beta(T, vector<double>(states_amount, 0)),
-    gamma(T, vector<double>(states_amount, 0));
-    for (size_t i = 0; i < states_amount; i++) {
-        alpha[0][i] = p[i] * b(i, O[0]);
-        beta[T-1][i] = 1;
-    }
-    for (size_t t = 1; t < T; t++)
-        for (size_t j = 0; j < states_amount; j++) {
-            double sum = 0;
-            for (size_t i = 0; i < states_amount; i++)
-                sum += alpha[t - 1][i] * a(i, j);
-            alpha[t][j] = b(j, O[t]) * sum;
+void models::probability_model_t::forward_step(const vector<double> &alpha, size_t o, vector<double> &next) const {
+    next.assign(states_amount, 0);
+    for (size_t j = 0; j < states_amount; j++) {
+        if (alpha.empty()) {
+            next[j] = p[j] * b(j, o);
+            continue;
         }
-    double P = accumulate(alpha[T-1].begin(), alpha[T-1].end(), 0.0);
-    for (size_t t = T-1; t > 0; t--)
-        for (size_t i = 0; i < states_amount; i++)
-            for (size_t j = 0; j < states_amount; j++)
-                beta[t-1][i] += beta[t][j] * a(i, j) * b(j, O[t-1]);
-    for (size_t t = 0; t < T; t++)
+        double sum = 0;
         for (size_t i = 0; i < states_amount; i++)
-            gamma[t][i] = alpha[t][i] * beta[t][i] / P;
-    return utils::arg_max(gamma.back());
+            sum += alpha[i] * a(i, j);
+        next[j] = b(j, o) * sum;
+    }
+}
+
+void models::probability_model_t::forward(vector<double> &alpha, size_t o) const {
+    vector<double> next;
+    forward_step(alpha, o, next);
+    alpha.swap(next);
+}
+
+size_t models::probability_model_t::predict_last_state(const vector<double> &alpha) const {
+    // backward variables of the last observation are ones, so its gamma is alpha / P
+    double P = accumulate(alpha.begin(), alpha.end(), 0.0);
+    vector<double> gamma(alpha.size());
+    for (size_t i = 0; i < alpha.size(); i++)
+        gamma[i] = alpha[i] / P;
+    return utils::arg_max(gamma);
+}
+
+// TODO: Need special double for extra low exponent
+size_t models::probability_model_t::predict_state(const vector<size_t> &O) const {
+    // only gamma of the last observation is used, it needs forward variables only
+    vector<double> alpha, next;
+    for (size_t o : O) {
+        forward_step(alpha, o, next);
+        alpha.swap(next);
+    }
+    return predict_last_state(alpha);
 }
 
 void models::probability_model_t::save(const string &path) const {
@@ -163,3 +175,50 @@ void models::probability_model_t::load(const string &path) {
     in.close();
 }
 
+
+namespace {
+    const uint32_t HMM_HEADER = model_file::tag("HMHD");
+    const uint32_t HMM_P = model_file::tag("HMMP");
+    const uint32_t HMM_A = model_file::tag("HMMA");
+    const uint32_t HMM_B = model_file::tag("HMMB");
+}
+
+void models::probability_model_t::save_binary(model_file::writer_t &writer) const {
+    const vector<uint64_t> header = {states_amount, observations_amount};
+    vector<double> a_values, b_values;
+    a_values.reserve(states_amount * states_amount);
+    b_values.reserve(states_amount * observations_amount);
+    for (size_t i = 0; i < states_amount; i++) {
+        for (size_t j = 0; j < states_amount; j++)
+            a_values.push_back(a(i, j));
+        for (size_t k = 0; k < observations_amount; k++)
+            b_values.push_back(b(i, k));
+    }
+    writer.add(HMM_HEADER, 0, header);
+    writer.add(HMM_P, 0, p);
+    writer.add(HMM_A, 0, a_values);
+    writer.add(HMM_B, 0, b_values);
+}
+
+bool models::probability_model_t::load_binary(const model_file::reader_t &reader) {
+    size_t header_amount = 0, p_amount = 0, a_amount = 0, b_amount = 0;
+    const uint64_t *header = reader.get<uint64_t>(HMM_HEADER, 0, header_amount);
+    const double *p_values = reader.get<double>(HMM_P, 0, p_amount);
+    const double *a_values = reader.get<double>(HMM_A, 0, a_amount);
+    const double *b_values = reader.get<double>(HMM_B, 0, b_amount);
+    if (header == nullptr || header_amount != 2 || p_values == nullptr || a_values == nullptr || b_values == nullptr ||
+        p_amount != header[0] || a_amount != header[0] * header[0] || b_amount != header[0] * header[1])
+        return false;
+    this->states_amount = header[0];
+    this->observations_amount = header[1];
+    this->p.assign(p_values, p_values + p_amount);
+    this->a = Matrix<double>(states_amount, states_amount);
+    this->b = Matrix<double>(states_amount, observations_amount);
+    for (size_t i = 0; i < states_amount; i++) {
+        for (size_t j = 0; j < states_amount; j++)
+            a(i, j) = a_values[i * states_amount + j];
+        for (size_t k = 0; k < observations_amount; k++)
+            b(i, k) = b_values[i * observations_amount + k];
+    }
+    return true;
+}
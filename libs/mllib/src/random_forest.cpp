@@ -96,6 +96,138 @@ map<size_t, double> mllib::calculation::compute_probabilities(map<size_t, size_t
     return res;
 }
 
+float mllib::calculation::quantize_threshold(double threshold) {
+    // the greatest float not greater than threshold: for float x, x > threshold <=> x > result
+    float result = float(threshold);
+    if (double(result) > threshold)
+        result = nextafterf(result, -numeric_limits<float>::infinity());
+    return result;
+}
+
+mllib::calculation::split_counts_t::split_counts_t(const vector<size_t> &labels) :
+left(labels.size(), 0),
+right(labels)
+{
+    for (auto &x : labels) {
+        n_right += x;
+        right_squares += x * x;
+    }
+}
+
+double mllib::calculation::gini_criterion_t::score(const split_counts_t &counts) const {
+    // impurity of side is 1 - sum of squares / n^2, empty side has impurity 1
+    size_t n = counts.n_left + counts.n_right;
+    double left_gini = counts.left_squares > 0 ?
+            1.0 - double(counts.left_squares) / double(counts.n_left * counts.n_left) : 1.0;
+    double right_gini = counts.right_squares > 0 ?
+            1.0 - double(counts.right_squares) / double(counts.n_right * counts.n_right) : 1.0;
+    return left_gini * (double(counts.n_left) / double(n)) + right_gini * (double(counts.n_right) / double(n));
+}
+
+namespace {
+    double dense_entropy(const vector<size_t> &labels, size_t n) {
+        double sum = 0.0;
+        for (auto &x : labels)
+            if (x > 0)
+                sum += (double(x) / double(n)) * log2(double(x) / double(n));
+        return -sum;
+    }
+}
+
+mllib::calculation::entropy_criterion_t::entropy_criterion_t(const vector<size_t> &labels) {
+    size_t n = 0;
+    for (auto &x : labels)
+        n += x;
+    h_parent = dense_entropy(labels, n);
+}
+
+double mllib::calculation::entropy_criterion_t::score(const split_counts_t &counts) const {
+    double n = double(counts.n_left + counts.n_right);
+    double h_left = dense_entropy(counts.left, counts.n_left);
+    double h_right = dense_entropy(counts.right, counts.n_right);
+    return h_parent - ((double(counts.n_left) / n) * h_left + (double(counts.n_right) / n) * h_right);
+}
+
+namespace {
+    /// Field `key=value` of line of text format.
+    struct field_t {
+        const char *key;
+        size_t key_size;
+        const char *value;
+        const char *value_end;
+
+        bool is(const char *name) const {
+            return strlen(name) == key_size && memcmp(key, name, key_size) == 0;
+        }
+        string str() const {
+            return {value, value_end};
+        }
+    };
+
+    const char *line_end(const char *pos, const char *end) {
+        auto found = static_cast<const char *>(memchr(pos, '\n', size_t(end - pos)));
+        return found == nullptr ? end : found;
+    }
+
+    bool is_blank(const char *begin, const char *end) {
+        for (; begin != end; ++begin)
+            if (!isspace(static_cast<unsigned char>(*begin)))
+                return false;
+        return true;
+    }
+
+    /**
+     * Read the next field of line, values with braces may contain commas.
+     *
+     * @param pos position in line, it is moved past the field;
+     * @param end end of line;
+     * @param field output field.
+     *
+     * @return false if there are no more fields.
+     */
+    bool next_field(const char *&pos, const char *end, field_t &field) {
+        while (pos != end && (*pos == ',' || isspace(static_cast<unsigned char>(*pos))))
+            ++pos;
+        const char *eq = find(pos, end, '=');
+        if (eq == end) return false;
+        const char *cur = eq + 1;
+        for (int level = 0; cur != end && (level > 0 || *cur != ','); ++cur)
+            level += *cur == '{' ? 1 : *cur == '}' ? -1 : 0;
+        field = {pos, size_t(eq - pos), eq + 1, cur};
+        pos = cur;
+        return true;
+    }
+
+    // numbers are followed by comma, newline or the end of text, which is terminated by zero
+    size_t to_size(const field_t &field) {
+        return strtoull(field.value, nullptr, 10);
+    }
+
+    double to_double(const field_t &field) {
+        return strtod(field.value, nullptr);
+    }
+
+    /// Parse map `{label:probability, ...}`.
+    map<size_t, double> to_probabilities(const field_t &field) {
+        map<size_t, double> result;
+        const char *pos = field.value, *end = field.value_end;
+        if (pos != end && *pos == '{') ++pos;
+        while (pos != end && *pos != '}') {
+            char *next = nullptr;
+            size_t key = strtoull(pos, &next, 10);
+            if (next == pos || *next != ':') break;
+            pos = next + 1;
+            double value = strtod(pos, &next);
+            if (next == pos) break;
+            result[key] = value;
+            pos = next;
+            while (pos != end && (*pos == ',' || *pos == ' '))
+                ++pos;
+        }
+        return result;
+    }
+}
+
 mllib::models::DecisionTree::node::node(node &&n) noexcept :
 is_leaf(n.is_leaf),
 depth(n.depth),
@@ -158,147 +290,482 @@ string mllib::models::DecisionTree::node::node_def(size_t cur_id) {
     return ss.str();
 }
 
-tuple<size_t, size_t, size_t> mllib::models::DecisionTree::node::parse(const vector<string> &lines) {
+tuple<size_t, size_t, size_t> mllib::models::DecisionTree::node::parse(const char *first, const char *first_end,
+                                                                        const char *second, const char *second_end) {
     size_t id = 0, left_id = 0, right_id = 0;
     // Parse Node defenition
-    const regex regex_node_id("id=([0-9]+)");
-    const regex regex_node_leaf("leaf=([^,]+)");
-    const regex regex_node_depth("depth=([0-9]+)");
-    const regex regex_node_h("h=([-+]?([0-9]*[.])?[0-9]+([eE][-+]?[0-9]+)?)");
-    const regex regex_node_probs("probs=(\\{[^}]+\\})");
-    const regex regex_node_feature("feature=([0-9]+)");
-    const regex regex_node_threshold("threshold=([-+]?([0-9]*[.])?[0-9]+([eE][-+]?[0-9]+)?)");
-    const regex regex_node_left("left=([0-9]+)");
-    const regex regex_node_right("right=([0-9]+)");
-    smatch match;
-    if (regex_search(lines[0], match, regex_node_id))
-        id = stoull(match[1].str());
-    if (regex_search(lines[0], match, regex_node_leaf))
-        is_leaf = match[1].str() == "1";
-    if (regex_search(lines[0], match, regex_node_leaf))
-        depth = stoull(match[1].str());
-    if (is_leaf) {
-        if (regex_search(lines[1], match, regex_node_h))
-            h_value = stod(match[1].str());
-        if (regex_search(lines[1], match, regex_node_probs))
-            probabilities =
-                    utils::str_to_map<size_t, double>(match[1].str(),
-                                                      [] (string s) { return stoull(s); },
-                                                      [] (string s) { return stod(s); });
-    } else {
-        if (regex_search(lines[1], match, regex_node_feature))
-            feature_idx = stoull(match[1].str());
-        if (regex_search(lines[1], match, regex_node_threshold))
-            threshold = stod(match[1].str());
-        if (regex_search(lines[1], match, regex_node_left))
-            left_id = stoull(match[1].str());
-        if (regex_search(lines[1], match, regex_node_right))
-            right_id = stoull(match[1].str());
+    field_t field = {};
+    while (next_field(first, first_end, field)) {
+        if (field.is("id"))
+            id = to_size(field);
+        else if (field.is("leaf"))
+            is_leaf = field.value_end - field.value == 1 && *field.value == '1';
+        else if (field.is("depth"))
+            depth = to_size(field);
+    }
+    while (next_field(second, second_end, field)) {
+        if (is_leaf) {
+            if (field.is("h"))
+                h_value = to_double(field);
+            else if (field.is("probs"))
+                probabilities = to_probabilities(field);
+        } else {
+            if (field.is("feature"))
+                feature_idx = to_size(field);
+            else if (field.is("threshold"))
+                threshold = to_double(field);
+            else if (field.is("left"))
+                left_id = to_size(field);
+            else if (field.is("right"))
+                right_id = to_size(field);
+        }
     }
     return {id, left_id, right_id};
 }
 
-void mllib::models::DecisionTree::split_samples_by_threshold(size_t &feature_idx,
-                                              double &threshold,
-                                              vector<size_t> &samples,
-                                              vector<size_t> &left,
-                                              vector<size_t> &right,
-                                              Data &data) {
-    left.clear();
-    right.clear();
-    for (auto &idx : samples)
-        if (data.get_feature(idx, feature_idx) > threshold)
-            right.push_back(idx);
-        else
-            left.push_back(idx);
+template <class Function>
+void mllib::models::DecisionTree::for_each_index(size_t amount, bool parallel, Function function) const {
+    if (task_pool == nullptr || !parallel || amount < 2) {
+        for (size_t i = 0; i < amount; i++)
+            function(i);
+        return;
+    }
+    TaskPool::group_t group;
+    for (size_t i = 1; i < amount; i++)
+        task_pool->run(group, [&function, i] { function(i); });
+    function(0);
+    task_pool->wait(group);
 }
 
+template <class Criterion>
 void mllib::models::DecisionTree::choose_best_split(node *node,
-                       vector<size_t> &samples,
-                       Data &data) {
-    vector<size_t> features_ids = data.generate_features(this->get_feature_amount, this->eng);
-    size_t best_feature_idx = features_ids[0];
-    double best_threshold = 0.0, best_score = lower_better ? 1e9 : -1e9, threshold;
-    map<size_t, size_t> labels = calculation::compute_labels(samples, data);
-    vector<pair<size_t, double>> sample_feature_values;
-    sample_feature_values.reserve(samples.size());
-    for (auto &idx : samples)
-        sample_feature_values.emplace_back(idx, 0.0);
-    for (auto &feature_idx : features_ids) {
-        for (auto &p : sample_feature_values)
-            p.second = data.get_feature(p.first, feature_idx);
-        sort(sample_feature_values.begin(), sample_feature_values.end(),
-                  [](auto a, auto b) { return a.second < b.second; });
-        map<size_t, size_t> left, right = labels;
-        for (size_t i = 0; i < samples.size() - 1;) {
-            threshold = (sample_feature_values[i].second + sample_feature_values[i+1].second) / 2.0;
-            while (i < samples.size() && sample_feature_values[i].second <= threshold) {
-                size_t target = data.get_target(sample_feature_values[i].first);
-                left[target]++;
-                right[target]--;
+                       size_t begin,
+                       size_t end,
+                       const vector<size_t> &labels,
+                       Data &data,
+                       mt19937_64 &engine) {
+    struct best_t {
+        bool found = false;
+        double score = Criterion::lower_better ? 1e9 : -1e9;
+        double threshold = 0.0;
+    };
+    vector<size_t> features_ids = data.generate_features(this->get_feature_amount, engine);
+    vector<best_t> feature_best(features_ids.size());
+    const Criterion criterion(labels);
+    const size_t size = end - begin;
+    for_each_index(features_ids.size(), size >= PARALLEL_NODE_SIZE, [&](size_t j) {
+        // samples are already in order of feature, so thresholds are swept without sorting
+        size_t feature_idx = features_ids[j];
+        const uint32_t *sorted = presorted.order.data() + feature_idx * presorted.samples_amount + begin;
+        const double *values = presorted.values.data() + feature_idx * presorted.samples_amount + begin;
+        best_t &best = feature_best[j];
+        calculation::split_counts_t counts(labels);
+        for (size_t i = 0; i < size - 1;) {
+            double threshold = (values[i] + values[i+1]) / 2.0;
+            while (i < size && values[i] <= threshold) {
+                counts.move_left(dense_targets[sorted[i]], sample_weights[sorted[i]]);
                 i++;
             }
-            if (i == samples.size()) continue;
-            if (i > 0 && sample_feature_values[i-1].second == threshold)
-                threshold = (sample_feature_values[i-1].second + sample_feature_values[i].second) / 2.0;
-            double value = criterion_func(left, right);
-            if (lower_better && value <= best_score || !lower_better && value >= best_score) {
-                best_score = value;
-                best_threshold = threshold;
-                best_feature_idx = feature_idx;
+            if (i == size) continue;
+            if (i > 0 && values[i-1] == threshold)
+                threshold = (values[i-1] + values[i]) / 2.0;
+            double value = criterion.score(counts);
+            if (calculation::is_not_worse<Criterion>(value, best.score)) {
+                best.score = value;
+                best.threshold = threshold;
+                best.found = true;
             }
         }
-    }
+    });
+    // features are reduced in order, so ties are broken as by sequential sweep
+    size_t best_feature_idx = features_ids[0];
+    best_t best;
+    for (size_t j = 0; j < features_ids.size(); j++)
+        if (feature_best[j].found && calculation::is_not_worse<Criterion>(feature_best[j].score, best.score)) {
+            best = feature_best[j];
+            best_feature_idx = features_ids[j];
+        }
     node->feature_idx = best_feature_idx;
-    node->threshold = best_threshold;
+    node->threshold = best.threshold;
+}
+
+void mllib::models::DecisionTree::partition_samples(size_t begin, size_t middle, size_t end, size_t feature_idx) {
+    const size_t n = presorted.samples_amount;
+    const uint32_t *split = presorted.order.data() + feature_idx * n;
+    for (size_t i = begin; i < end; i++)
+        presorted.goes_right[split[i]] = i >= middle;
+    const bool parallel = task_pool != nullptr && end - begin >= PARALLEL_NODE_SIZE;
+    for_each_index(presorted.order.size() / n, parallel, [&](size_t f) {
+        if (f == feature_idx) return;
+        // nodes own disjoint ranges of scratch buffers, features of parallel node take their own
+        vector<uint32_t> own_buffer(parallel ? end - middle : 0);
+        vector<double> own_values_buffer(parallel ? end - middle : 0);
+        uint32_t *buffer = parallel ? own_buffer.data() : presorted.buffer.data() + begin;
+        double *values_buffer = parallel ? own_values_buffer.data() : presorted.values_buffer.data() + begin;
+        uint32_t *sorted = presorted.order.data() + f * n;
+        double *values = presorted.values.data() + f * n;
+        size_t left = begin, right = 0;
+        for (size_t i = begin; i < end; i++)
+            if (presorted.goes_right[sorted[i]]) {
+                buffer[right] = sorted[i];
+                values_buffer[right++] = values[i];
+            } else {
+                sorted[left] = sorted[i];
+                values[left++] = values[i];
+            }
+        copy(buffer, buffer + right, sorted + left);
+        copy(values_buffer, values_buffer + right, values + left);
+    });
+}
+
+mllib::models::DecisionTree::node* mllib::models::DecisionTree::construct_node(size_t depth,
+                     size_t begin,
+                     size_t end,
+                     Data &data,
+                     mt19937_64 &engine) {
+    node* node = new DecisionTree::node();
+    node->depth = depth;
+    vector<size_t> counts(dense_classes_amount, 0);
+    size_t size = 0;
+    for (size_t i = begin; i < end; i++) {
+        uint32_t idx = presorted.order[i];
+        counts[dense_targets[idx]] += sample_weights[idx];
+        size += sample_weights[idx];
+    }
+    map<size_t, size_t> labels;
+    for (size_t c = 0; c < dense_classes_amount; c++)
+        if (counts[c] > 0)
+            labels[dense_labels[c]] = counts[c];
+    double h = calculation::compute_entropy(labels);
     node->h_value = node_value_func(labels);
+    if (depth == max_depth || size < min_samples_split || size == 1 || h == 0) {
+        node->is_leaf = true;
+        node->probabilities = calculation::compute_probabilities(labels);
+        return node;
+    }
+    // gini is the only criterion which is minimised
+    if (lower_better)
+        choose_best_split<calculation::gini_criterion_t>(node, begin, end, counts, data, engine);
+    else
+        choose_best_split<calculation::entropy_criterion_t>(node, begin, end, counts, data, engine);
+    // left child takes prefix of range sorted by split feature
+    const uint32_t *sorted = presorted.order.data() + node->feature_idx * presorted.samples_amount;
+    const double *values = presorted.values.data() + node->feature_idx * presorted.samples_amount;
+    size_t middle = begin, left_size = 0;
+    while (middle < end && values[middle] <= node->threshold)
+        left_size += sample_weights[sorted[middle++]];
+    if (left_size < min_samples_leaf || size - left_size < min_samples_leaf) {
+        node->is_leaf = true;
+        node->probabilities = calculation::compute_probabilities(labels);
+        return node;
+    }
+    partition_samples(begin, middle, end, node->feature_idx);
+    if (end - begin < PARALLEL_NODE_SIZE) {
+        node->left = construct_node(depth + 1, begin, middle, data, engine);
+        node->right = construct_node(depth + 1, middle, end, data, engine);
+        return node;
+    }
+    // children of large node draw from their own engines, so tree doesn't depend on order of building
+    mt19937_64 engines[2] = {mt19937_64(engine()), mt19937_64(engine())};
+    for_each_index(2, true, [&](size_t i) {
+        if (i == 0)
+            node->left = construct_node(depth + 1, begin, middle, data, engines[0]);
+        else
+            node->right = construct_node(depth + 1, middle, end, data, engines[1]);
+    });
+    return node;
+}
+
+void mllib::models::DecisionTree::init_presorted(const SortedData &sorted) {
+    // tree's samples keep the order of all samples, each of them appears once with its weight
+    const size_t n = sample_weights.size() - size_t(count(sample_weights.begin(), sample_weights.end(), 0u));
+    presorted.samples_amount = n;
+    presorted.order.resize(n * sorted.features_size());
+    presorted.values.resize(n * sorted.features_size());
+    for (size_t f = 0, k = 0; f < sorted.features_size(); f++) {
+        const uint32_t *order = sorted.get_order(f);
+        const double *values = sorted.get_values(f);
+        for (size_t i = 0; i < sorted.samples_size(); i++)
+            if (sample_weights[order[i]] > 0) {
+                presorted.order[k] = order[i];
+                presorted.values[k++] = values[i];
+            }
+    }
+    presorted.buffer.resize(n);
+    presorted.values_buffer.resize(n);
+    presorted.goes_right.assign(sorted.samples_size(), 0);
+}
+
+void mllib::models::DecisionTree::init_sample_weights(const Data &data, const vector<uint32_t> &weights) {
+    if (weights.empty())
+        sample_weights.assign(data.samples_size(), 1);
+    else
+        sample_weights = weights;
+}
+
+vector<uint32_t> mllib::models::DecisionTree::draw_bootstrap(const Data &data, size_t amount) {
+    return data.generate_bootstrap(amount, eng);
+}
+
+void mllib::models::DecisionTree::init_dense_targets(const Data &data) {
+    // labels are numbered in ascending order, so criteria sum them in the same order as maps
+    vector<size_t> targets(data.samples_size());
+    for (size_t i = 0; i < targets.size(); i++)
+        targets[i] = data.get_target(i);
+    dense_labels = targets;
+    sort(dense_labels.begin(), dense_labels.end());
+    dense_labels.erase(unique(dense_labels.begin(), dense_labels.end()), dense_labels.end());
+    dense_classes_amount = dense_labels.size();
+    dense_targets.resize(targets.size());
+    for (size_t i = 0; i < targets.size(); i++)
+        dense_targets[i] = uint32_t(lower_bound(dense_labels.begin(), dense_labels.end(), targets[i]) - dense_labels.begin());
+}
+
+void mllib::models::DecisionTree::clear_dense_targets() {
+    dense_targets = vector<uint32_t>();
+    dense_labels = vector<size_t>();
+    dense_classes_amount = 0;
+    histogram_offsets = vector<size_t>();
+    presorted = presorted_t();
+    sample_weights = vector<uint32_t>();
+}
+
+void mllib::models::DecisionTree::build_histogram(const vector<size_t> &samples,
+                                                  const BinnedData &binned,
+                                                  vector<uint32_t> &histogram) const {
+    histogram.assign(histogram_offsets.back(), 0);
+    for_each_index(binned.features_size(), samples.size() >= PARALLEL_NODE_SIZE, [&](size_t f) {
+        const uint8_t *column = binned.get_column(f);
+        uint32_t *counts = histogram.data() + histogram_offsets[f];
+        for (auto &idx : samples)
+            counts[column[idx] * dense_classes_amount + dense_targets[idx]] += sample_weights[idx];
+    });
+}
+
+template <class Criterion>
+bool mllib::models::DecisionTree::choose_best_bin(node *node,
+                                                  const vector<size_t> &samples,
+                                                  const vector<size_t> &labels,
+                                                  const vector<uint32_t> &histogram,
+                                                  Data &data,
+                                                  const BinnedData &binned,
+                                                  mt19937_64 &engine,
+                                                  size_t &best_bin) {
+    vector<size_t> features_ids = data.generate_features(this->get_feature_amount, engine);
+    double best_score = Criterion::lower_better ? 1e9 : -1e9;
+    bool found = false;
+    const Criterion criterion(labels);
+    auto check = [&](const calculation::split_counts_t &split, size_t feature_idx, size_t bin) {
+        double value = criterion.score(split);
+        if (calculation::is_not_worse<Criterion>(value, best_score)) {
+            best_score = value;
+            best_bin = bin;
+            node->feature_idx = feature_idx;
+            node->threshold = binned.get_threshold(feature_idx, bin);
+            found = true;
+        }
+    };
+    // node without histogram counts bins of each chosen feature on its own,
+    // tiny node sorts its bins instead; all ways check splits after non-empty bins
+    auto scan = [&](const uint32_t *counts, size_t feature_idx) {
+        calculation::split_counts_t split(labels);
+        for (size_t bin = 0; bin + 1 < binned.bins_size(feature_idx); bin++, counts += dense_classes_amount) {
+            bool moved = false;
+            for (size_t c = 0; c < dense_classes_amount; c++)
+                if (counts[c] > 0) {
+                    split.move_left(c, counts[c]);
+                    moved = true;
+                }
+            if (split.n_right == 0) break;
+            if (moved)
+                check(split, feature_idx, bin);
+        }
+    };
+    bool tiny = histogram.empty() && samples.size() < BinnedData::MAX_BINS / 4;
+    vector<tuple<uint8_t, uint32_t, uint32_t>> sample_bins(tiny ? samples.size() : 0);
+    vector<uint32_t> feature_histogram;
+    for (auto &feature_idx : features_ids) {
+        const uint8_t *column = binned.get_column(feature_idx);
+        if (!histogram.empty()) {
+            scan(histogram.data() + histogram_offsets[feature_idx], feature_idx);
+        } else if (!tiny) {
+            feature_histogram.assign(binned.bins_size(feature_idx) * dense_classes_amount, 0);
+            for (auto &idx : samples)
+                feature_histogram[column[idx] * dense_classes_amount + dense_targets[idx]] += sample_weights[idx];
+            scan(feature_histogram.data(), feature_idx);
+        } else {
+            calculation::split_counts_t split(labels);
+            for (size_t i = 0; i < samples.size(); i++)
+                sample_bins[i] = make_tuple(column[samples[i]], dense_targets[samples[i]], sample_weights[samples[i]]);
+            sort(sample_bins.begin(), sample_bins.end());
+            for (size_t i = 0; i < sample_bins.size();) {
+                uint8_t bin = get<0>(sample_bins[i]);
+                for (; i < sample_bins.size() && get<0>(sample_bins[i]) == bin; i++)
+                    split.move_left(get<1>(sample_bins[i]), get<2>(sample_bins[i]));
+                if (split.n_right == 0) break;
+                check(split, feature_idx, bin);
+            }
+        }
+    }
+    return found;
 }
 
 mllib::models::DecisionTree::node* mllib::models::DecisionTree::construct_node(size_t depth,
                      vector<size_t> &samples,
-                     Data &data) {
+                     Data &data,
+                     const BinnedData &binned,
+                     vector<uint32_t> &histogram,
+                     mt19937_64 &engine) {
     node* node = new DecisionTree::node();
     node->depth = depth;
-    auto labels = calculation::compute_labels(samples, data);
+    vector<size_t> counts(dense_classes_amount, 0);
+    size_t size = 0;
+    for (auto &idx : samples) {
+        counts[dense_targets[idx]] += sample_weights[idx];
+        size += sample_weights[idx];
+    }
+    map<size_t, size_t> labels;
+    for (size_t c = 0; c < dense_classes_amount; c++)
+        if (counts[c] > 0)
+            labels[dense_labels[c]] = counts[c];
     double h = calculation::compute_entropy(labels);
-    if (depth == max_depth || samples.size() < min_samples_split || samples.size() == 1 || h == 0) {
+    node->h_value = node_value_func(labels);
+    size_t best_bin = 0;
+    bool found = false;
+    if (!(depth == max_depth || size < min_samples_split || size == 1 || h == 0))
+        found = lower_better ?
+                choose_best_bin<calculation::gini_criterion_t>(node, samples, counts, histogram, data, binned, engine, best_bin) :
+                choose_best_bin<calculation::entropy_criterion_t>(node, samples, counts, histogram, data, binned, engine, best_bin);
+    vector<size_t> left, right;
+    size_t left_size = 0;
+    if (found) {
+        const uint8_t *column = binned.get_column(node->feature_idx);
+        for (auto &idx : samples)
+            if (column[idx] > best_bin) {
+                right.push_back(idx);
+            } else {
+                left.push_back(idx);
+                left_size += sample_weights[idx];
+            }
+    }
+    if (!found || left_size < min_samples_leaf || size - left_size < min_samples_leaf) {
         node->is_leaf = true;
-        node->h_value = node_value_func(labels);
         node->probabilities = calculation::compute_probabilities(labels);
-    } else {
-        choose_best_split(node, samples, data);
-        vector<size_t> left, right;
-        split_samples_by_threshold(node->feature_idx, node->threshold, samples, left, right, data);
-        if (left.size() < min_samples_leaf || right.size() < min_samples_leaf) {
-            node->is_leaf = true;
-            node->h_value = node_value_func(labels);
-            node->probabilities = calculation::compute_probabilities(labels);
+        return node;
+    }
+    // histogram of the smaller child is built, the larger one gets parent's minus it;
+    // children too small to pay for histogram go without it
+    bool left_smaller = left.size() < right.size();
+    vector<uint32_t> smaller;
+    if (!histogram.empty() && max(left.size(), right.size()) * binned.features_size() >= histogram.size()) {
+        build_histogram(left_smaller ? left : right, binned, smaller);
+        for (size_t i = 0; i < histogram.size(); i++)
+            histogram[i] -= smaller[i];
+    } else
+        histogram = vector<uint32_t>();
+    vector<uint32_t> &left_histogram = left_smaller ? smaller : histogram;
+    vector<uint32_t> &right_histogram = left_smaller ? histogram : smaller;
+    if (samples.size() < PARALLEL_NODE_SIZE) {
+        node->left = construct_node(depth + 1, left, data, binned, left_histogram, engine);
+        node->right = construct_node(depth + 1, right, data, binned, right_histogram, engine);
+        return node;
+    }
+    // children of large node draw from their own engines, so tree doesn't depend on order of building
+    mt19937_64 engines[2] = {mt19937_64(engine()), mt19937_64(engine())};
+    for_each_index(2, true, [&](size_t i) {
+        if (i == 0)
+            node->left = construct_node(depth + 1, left, data, binned, left_histogram, engines[0]);
+        else
+            node->right = construct_node(depth + 1, right, data, binned, right_histogram, engines[1]);
+    });
+    return node;
+}
+
+void mllib::models::DecisionTree::compile() {
+    compiled = compiled_t();
+    flat_nodes.clear();
+    flat_nodes_f.clear();
+    leaf_labels.clear();
+    classes.clear();
+    leaf_probabilities.clear();
+    if (root == nullptr) return;
+    // breadth-first order keeps children of node next to each other
+    vector<const node *> order = {root};
+    for (size_t i = 0; i < order.size(); i++) {
+        const node *cur = order[i];
+        if (cur->is_leaf) {
+            for (auto &p : cur->probabilities)
+                classes.push_back(p.first);
         } else {
-            node->left = construct_node(depth + 1, left, data);
-            node->right = construct_node(depth + 1, right, data);
+            order.push_back(cur->left);
+            order.push_back(cur->right);
         }
     }
-    return node;
+    sort(classes.begin(), classes.end());
+    classes.erase(unique(classes.begin(), classes.end()), classes.end());
+    flat_nodes.resize(order.size());
+    flat_nodes_f.resize(order.size());
+    uint32_t next = 1;
+    for (size_t i = 0; i < order.size(); i++) {
+        const node *cur = order[i];
+        flat_node &flat = flat_nodes[i];
+        flat_node_f &flat_f = flat_nodes_f[i];
+        if (!cur->is_leaf) {
+            flat.threshold = cur->threshold;
+            flat.feature_idx = uint32_t(cur->feature_idx);
+            flat.left = next;
+            flat_f.threshold = calculation::quantize_threshold(cur->threshold);
+            flat_f.feature_idx = flat.feature_idx;
+            flat_f.left = flat.left;
+            next += 2;
+            continue;
+        }
+        flat.feature_idx = flat_f.feature_idx = uint32_t(leaf_labels.size());
+        size_t max_label = 0;
+        double max_prob = 0.0;
+        for (auto &p : cur->probabilities)
+            if (max_prob < p.second) {
+                max_label = p.first;
+                max_prob = p.second;
+            }
+        leaf_labels.push_back(max_label);
+        leaf_probabilities.resize(leaf_probabilities.size() + classes.size(), 0.0);
+        double *row = leaf_probabilities.data() + leaf_probabilities.size() - classes.size();
+        for (auto &p : cur->probabilities)
+            row[lower_bound(classes.begin(), classes.end(), p.first) - classes.begin()] = p.second;
+    }
+    compiled.nodes = flat_nodes.data();
+    compiled.nodes_f = flat_nodes_f.data();
+    compiled.leaf_labels = leaf_labels.data();
+    compiled.classes = classes.data();
+    compiled.leaf_probabilities = leaf_probabilities.data();
+    compiled.nodes_amount = flat_nodes.size();
+    compiled.leaves_amount = leaf_labels.size();
+    compiled.classes_amount = classes.size();
 }
 
-map<size_t, double> mllib::models::DecisionTree::get_probabilities(const vector<double> &query) const {
-    auto node = root;
-    while (!node->is_leaf)
-        if (query[node->feature_idx] > node->threshold)
-            node = node->right;
-        else
-            node = node->left;
-    return node->probabilities;
+size_t mllib::models::DecisionTree::find_leaf(const double *query) const {
+    const flat_node *nodes = compiled.nodes;
+    uint32_t id = 0;
+    while (nodes[id].left != 0)
+        id = nodes[id].left + (query[nodes[id].feature_idx] > nodes[id].threshold);
+    return nodes[id].feature_idx;
 }
 
-map<size_t, double> mllib::models::DecisionTree::get_probabilities(size_t sample_idx, Data &data) const {
-    auto node = root;
-    while (!node->is_leaf)
-        if (data.get_feature(sample_idx, node->feature_idx) > node->threshold)
-            node = node->right;
-        else
-            node = node->left;
-    return node->probabilities;
+size_t mllib::models::DecisionTree::find_leaf(const float *query) const {
+    const flat_node_f *nodes = compiled.nodes_f;
+    uint32_t id = 0;
+    while (nodes[id].left != 0)
+        id = nodes[id].left + (query[nodes[id].feature_idx] > nodes[id].threshold);
+    return nodes[id].feature_idx;
+}
+
+size_t mllib::models::DecisionTree::find_leaf(size_t sample_idx, const Data &data) const {
+    const flat_node *nodes = compiled.nodes;
+    uint32_t id = 0;
+    while (nodes[id].left != 0)
+        id = nodes[id].left + (data.get_feature(sample_idx, nodes[id].feature_idx) > nodes[id].threshold);
+    return nodes[id].feature_idx;
 }
 
 void mllib::models::DecisionTree::get_tree_def(node *node, size_t id, queue<string> &queue) {
@@ -314,14 +781,13 @@ mllib::models::DecisionTree::DecisionTree(size_t max_depth,
                            size_t min_samples_split,
                            const string &criterion,
                            const string &max_features,
-                           size_t seed) {
+                           size_t seed,
+                           size_t max_bins) {
     criterion_func_name = criterion;
     if (criterion == "entropy") {
-        criterion_func = calculation::compute_IG;
         node_value_func = calculation::compute_entropy;
         lower_better = false;
     } else {
-        criterion_func = calculation::compute_gini;
         node_value_func = calculation::compute_gini_impurity;
         lower_better = true;
     }
@@ -337,6 +803,7 @@ mllib::models::DecisionTree::DecisionTree(size_t max_depth,
         seed = rd();
     }
     this->seed = seed;
+    this->max_bins = max_bins;
     this->eng = mt19937_64(seed);
     this->min_samples_leaf = min_samples_leaf;
     this->min_samples_split = min_samples_split;
@@ -349,13 +816,19 @@ max_depth(m.max_depth),
 min_samples_leaf(m.min_samples_leaf),
 min_samples_split(m.min_samples_split),
 seed(m.seed),
+max_bins(m.max_bins),
 eng(m.eng),
 criterion_func_name(std::move(m.criterion_func_name)),
 max_feature_func_name(std::move(m.max_feature_func_name)),
 get_feature_amount(std::move(m.get_feature_amount)),
 node_value_func(std::move(m.node_value_func)),
-criterion_func(std::move(m.criterion_func)),
-root(m.root)
+root(m.root),
+flat_nodes(std::move(m.flat_nodes)),
+flat_nodes_f(std::move(m.flat_nodes_f)),
+leaf_labels(std::move(m.leaf_labels)),
+classes(std::move(m.classes)),
+leaf_probabilities(std::move(m.leaf_probabilities)),
+compiled(m.compiled)
 {
     m.lower_better = false;
     m.max_depth = 0;
@@ -364,6 +837,7 @@ root(m.root)
     m.seed = 0;
     m.eng = mt19937_64(m.seed);
     m.root = nullptr;
+    m.compiled = compiled_t();
 }
 
 mllib::models::DecisionTree::~DecisionTree() {
@@ -376,13 +850,19 @@ mllib::models::DecisionTree &mllib::models::DecisionTree::operator=(mllib::model
     this->min_samples_leaf = m.min_samples_leaf;
     this->min_samples_split = m.min_samples_split;
     this->seed = m.seed;
+    this->max_bins = m.max_bins;
     this->eng = m.eng;
     this->criterion_func_name = std::move(m.criterion_func_name);
     this->max_feature_func_name = std::move(m.max_feature_func_name);
     this->get_feature_amount = std::move(m.get_feature_amount);
     this->node_value_func = std::move(m.node_value_func);
-    this->criterion_func = std::move(m.criterion_func);
     this->root = m.root;
+    this->flat_nodes = std::move(m.flat_nodes);
+    this->flat_nodes_f = std::move(m.flat_nodes_f);
+    this->leaf_labels = std::move(m.leaf_labels);
+    this->classes = std::move(m.classes);
+    this->leaf_probabilities = std::move(m.leaf_probabilities);
+    this->compiled = m.compiled;
     m.lower_better = false;
     m.max_depth = 0;
     m.min_samples_leaf = 0;
@@ -390,6 +870,7 @@ mllib::models::DecisionTree &mllib::models::DecisionTree::operator=(mllib::model
     m.seed = 0;
     m.eng = mt19937_64(m.seed);
     m.root = nullptr;
+    m.compiled = compiled_t();
     return *this;
 }
 
@@ -399,43 +880,75 @@ mllib::models::DecisionTree* mllib::models::DecisionTree::clone() {
             min_samples_leaf,
             min_samples_split);
     new_tree->seed = seed;
+    new_tree->max_bins = max_bins;
     new_tree->eng = mt19937_64(seed);
     new_tree->node_value_func = node_value_func;
-    new_tree->criterion_func = criterion_func;
     new_tree->lower_better = lower_better;
     new_tree->get_feature_amount = get_feature_amount;
     return new_tree;
 }
 
 void mllib::models::DecisionTree::fit(Data &data) {
-    vector<size_t> samples = data.generate_samples(data.samples_size(), this->eng);
-    root = construct_node(0, samples, data);
+    if (max_bins > 0) {
+        fit(data, BinnedData(data, max_bins));
+        return;
+    }
+    fit(data, SortedData(data));
+}
+
+void mllib::models::DecisionTree::fit(Data &data, const SortedData &sorted,
+                                      const vector<uint32_t> &weights, TaskPool *pool) {
+    task_pool = pool;
+    init_dense_targets(data);
+    init_sample_weights(data, weights);
+    init_presorted(sorted);
+    root = construct_node(0, 0, presorted.samples_amount, data, eng);
+    clear_dense_targets();
+    task_pool = nullptr;
+    compile();
+}
+
+void mllib::models::DecisionTree::fit(Data &data, const BinnedData &binned,
+                                      const vector<uint32_t> &weights, TaskPool *pool) {
+    task_pool = pool;
+    init_dense_targets(data);
+    init_sample_weights(data, weights);
+    vector<size_t> samples;
+    for (size_t i = 0; i < sample_weights.size(); i++)
+        if (sample_weights[i] > 0)
+            samples.push_back(i);
+    histogram_offsets.assign(1, 0);
+    for (size_t f = 0; f < binned.features_size(); f++)
+        histogram_offsets.push_back(histogram_offsets.back() + binned.bins_size(f) * dense_classes_amount);
+    vector<uint32_t> histogram;
+    if (samples.size() * binned.features_size() >= histogram_offsets.back())
+        build_histogram(samples, binned, histogram);
+    root = construct_node(0, samples, data, binned, histogram, eng);
+    clear_dense_targets();
+    task_pool = nullptr;
+    compile();
 }
 
 void mllib::models::DecisionTree::predict(Data &queries, vector<size_t> &result) {
-    for (size_t i = 0; i < result.size(); i++) {
-        map<size_t, double> labels = get_probabilities(i, queries);
-        size_t max_label = 0;
-        double max_prob = 0.0;
-        for (auto &p : labels)
-            if (max_prob < p.second) {
-                max_label = p.first;
-                max_prob = p.second;
-            }
-        result[i] = max_label;
-    }
+    for (size_t i = 0; i < result.size(); i++)
+        result[i] = compiled.leaf_labels[find_leaf(i, queries)];
 }
 
 size_t mllib::models::DecisionTree::predict(const vector<double> &query) {
-    map<size_t, double> labels = get_probabilities(query);
-    size_t max_label = 0;
-    double max_prob = 0.0;
-    for (auto &p : labels)
-        if (max_prob < p.second) {
-            max_label = p.first;
-            max_prob = p.second;
-        }
-    return max_label;
+    return compiled.leaf_labels[find_leaf(query.data())];
+}
+
+size_t mllib::models::DecisionTree::predict(size_t sample_idx, const Data &data) const {
+    return compiled.leaf_labels[find_leaf(sample_idx, data)];
+}
+
+size_t mllib::models::DecisionTree::predict(const vector<float> &query) const {
+    return compiled.leaf_labels[find_leaf(query.data())];
+}
+
+void mllib::models::DecisionTree::predict(const Matrix<float> &queries, vector<size_t> &result) const {
+    for (size_t i = 0; i < result.size(); i++)
+        result[i] = compiled.leaf_labels[find_leaf(queries.at(i, 0))];
 }
 
 void mllib::models::DecisionTree::predict_prob(Data &queries, vector<map<size_t, double>> &probabilities) {
@@ -444,14 +957,15 @@ void mllib::models::DecisionTree::predict_prob(Data &queries, vector<map<size_t,
         if (!dict.empty()) dict.clear();
     size_t n = queries.samples_size();
     for (size_t i = 0; i < n; i++) {
-        map<size_t, double> labels = get_probabilities(i, queries);
-        for (auto &p : labels)
-            probabilities[i][p.first] += p.second;
+        const double *row = compiled.leaf_probabilities + find_leaf(i, queries) * compiled.classes_amount;
+        for (size_t j = 0; j < compiled.classes_amount; j++)
+            if (row[j] != 0.0)
+                probabilities[i][compiled.classes[j]] += row[j];
     }
 }
 
 bool mllib::models::DecisionTree::valid() const {
-    return root != nullptr;
+    return compiled.nodes_amount > 0;
 }
 
 void mllib::models::DecisionTree::generate_definition_for_graphviz(mllib::models::DecisionTree::node *node, size_t id, size_t parent_id, ostream &out) {
@@ -481,7 +995,9 @@ void mllib::models::DecisionTree::draw(const string &path) {
         out << "digraph Tree {\n";
         out << "node [shape=box, style=\"filled\", color=\"black\", fontname=\"helvetica\"] ;\n";
         out << "edge [fontname=\"helvetica\"] ;\n";
-        generate_definition_for_graphviz(root, 0, 0, out);
+        // tree loaded from binary container has compiled nodes only
+        if (root != nullptr)
+            generate_definition_for_graphviz(root, 0, 0, out);
         out << "}";
     }
     out.close();
@@ -493,6 +1009,44 @@ void mllib::models::DecisionTree::draw(const string &path) {
     system(cmd.c_str());
 }
 
+vector<size_t> mllib::models::DecisionTree::get_labels() const {
+    vector<size_t> labels(compiled.leaf_labels, compiled.leaf_labels + compiled.leaves_amount);
+    sort(labels.begin(), labels.end());
+    labels.erase(unique(labels.begin(), labels.end()), labels.end());
+    return labels;
+}
+
+void mllib::models::DecisionTree::generate_node_code(uint32_t id, size_t depth, const vector<size_t> &labels,
+                                                     ostream &out) const {
+    string indent(depth * 4, ' ');
+    const flat_node_f &flat = compiled.nodes_f[id];
+    if (flat.left == 0) {
+        size_t label = compiled.leaf_labels[flat.feature_idx];
+        out << indent << "return " << lower_bound(labels.begin(), labels.end(), label) - labels.begin() << ";\n";
+        return;
+    }
+    // float threshold is written with enough digits to be read back exactly
+    stringstream threshold;
+    if (isinf(flat.threshold))
+        threshold << (flat.threshold < 0 ? "-" : "") << "std::numeric_limits<float>::infinity()";
+    else
+        threshold << scientific << setprecision(numeric_limits<float>::max_digits10 - 1) << flat.threshold << 'f';
+    out << indent << "if (x[" << flat.feature_idx << "] > " << threshold.str() << ") {\n";
+    generate_node_code(flat.left + 1, depth + 1, labels, out);
+    out << indent << "} else {\n";
+    generate_node_code(flat.left, depth + 1, labels, out);
+    out << indent << "}\n";
+}
+
+void mllib::models::DecisionTree::generate_code(ostream &out, const string &name, const vector<size_t> &labels) const {
+    out << "static size_t " << name << "(const float *x) {\n";
+    if (compiled.nodes_amount > 0)
+        generate_node_code(0, 1, labels, out);
+    else
+        out << "    return 0;\n";
+    out << "}\n";
+}
+
 string mllib::models::DecisionTree::get_saved_def() {
     stringstream ss;
     ss << "max_depth=" << max_depth << ',';
@@ -501,6 +1055,7 @@ string mllib::models::DecisionTree::get_saved_def() {
     ss << "seed=" << seed << ',';
     ss << "criterion=" << criterion_func_name << ',';
     ss << "max_features=" << max_feature_func_name << ',';
+    ss << "max_bins=" << max_bins << ',';
     ss << "root_id=" << 0 << '\n';
     queue<string> tree_def;
     get_tree_def(root, 0, tree_def);
@@ -519,82 +1074,88 @@ void mllib::models::DecisionTree::save(const string &path, ios_base::openmode mo
     out.close();
 }
 
-size_t mllib::models::DecisionTree::parse_header(const string &header) {
+size_t mllib::models::DecisionTree::parse_header(const char *begin, const char *end) {
     // Parse Tree header
-    const regex regex_max_depth("max_depth=([0-9]+)");
-    const regex regex_min_samples_leaf("min_samples_leaf=([0-9]+)");
-    const regex regex_min_samples_split("min_samples_split=([0-9]+)");
-    const regex regex_seed("seed=([0-9]+)");
-    const regex regex_criterion("criterion=(\\w+)");
-    const regex regex_max_features("max_features=(\\w+)");
-    const regex regex_root_id("root_id=([0-9]+)");
-    smatch match;
-    if (regex_search(header, match, regex_max_depth))
-        max_depth = stoull(match[1].str());
-    if (regex_search(header, match, regex_min_samples_leaf))
-        min_samples_leaf = stoull(match[1].str());
-    if (regex_search(header, match, regex_min_samples_split))
-        min_samples_split = stoull(match[1].str());
-    if (regex_search(header, match, regex_seed)) {
-        seed = stoull(match[1].str());
-        eng = mt19937_64(seed);
-    }
-    if (regex_search(header, match, regex_criterion)) {
-        criterion_func_name = match[1].str();
-        if (criterion_func_name == "entropy") {
-            criterion_func = calculation::compute_IG;
-            node_value_func = calculation::compute_entropy;
-            lower_better = false;
-        } else {
-            criterion_func = calculation::compute_gini;
-            node_value_func = calculation::compute_gini_impurity;
-            lower_better = true;
-        }
-    }
-    if (regex_search(header, match, regex_max_features)) {
-        max_feature_func_name = match[1].str();
-        if (max_feature_func_name == "auto" || max_feature_func_name == "sqrt")
-            get_feature_amount = calculation::_sqrt;
-        else if (max_feature_func_name == "log2")
-            get_feature_amount = calculation::_log2;
-        else
-            get_feature_amount = calculation::_none;
-    }
     size_t root_id = 0;
-    if (regex_search(header, match, regex_root_id))
-        root_id = stoull(match[1].str());
+    field_t field = {};
+    while (next_field(begin, end, field)) {
+        if (field.is("max_depth"))
+            max_depth = to_size(field);
+        else if (field.is("min_samples_leaf"))
+            min_samples_leaf = to_size(field);
+        else if (field.is("min_samples_split"))
+            min_samples_split = to_size(field);
+        else if (field.is("seed")) {
+            seed = to_size(field);
+            eng = mt19937_64(seed);
+        } else if (field.is("criterion")) {
+            criterion_func_name = field.str();
+            if (criterion_func_name == "entropy") {
+                        node_value_func = calculation::compute_entropy;
+                lower_better = false;
+            } else {
+                        node_value_func = calculation::compute_gini_impurity;
+                lower_better = true;
+            }
+        } else if (field.is("max_features")) {
+            max_feature_func_name = field.str();
+            if (max_feature_func_name == "auto" || max_feature_func_name == "sqrt")
+                get_feature_amount = calculation::_sqrt;
+            else if (max_feature_func_name == "log2")
+                get_feature_amount = calculation::_log2;
+            else
+                get_feature_amount = calculation::_none;
+        } else if (field.is("max_bins"))
+            max_bins = to_size(field);
+        else if (field.is("root_id"))
+            root_id = to_size(field);
+    }
     return root_id;
 }
 
-void mllib::models::DecisionTree::load_from_stream(istream &in) {
-    string line;
-    vector<string> lines(2);
-    map<size_t, tuple<node*, size_t, size_t>> nodes;
-    getline(in, line, '\n');
-    size_t root_id = parse_header(line);
-    size_t i = 0;
-    while(getline(in, line, '\n')) {
-        smatch match;
-        if (regex_match(line, match, regex("^\\s*$"))) {
-            break;
-        }
-        lines[i++] = line;
-        if (i == 2) {
-            i = 0;
-            node *new_node = new node();
-            size_t id, left_if, right_id;
-            std::tie(id, left_if, right_id) = new_node->parse(lines);
-            nodes[id] = {new_node, left_if, right_id};
-        }
+void mllib::models::DecisionTree::parse(const char *begin, const char *end) {
+    const char *header_end = line_end(begin, end);
+    size_t root_id = parse_header(begin, header_end);
+    // nodes sorted by id, their children are found by binary search
+    vector<tuple<size_t, node*, size_t, size_t>> nodes;
+    const char *pos = header_end == end ? end : header_end + 1;
+    while (pos != end) {
+        const char *first_end = line_end(pos, end);
+        if (first_end == end) break;
+        const char *second = first_end + 1, *second_end = line_end(second, end);
+        node *new_node = new node();
+        size_t id, left_id, right_id;
+        std::tie(id, left_id, right_id) = new_node->parse(pos, first_end, second, second_end);
+        nodes.emplace_back(id, new_node, left_id, right_id);
+        pos = second_end == end ? end : second_end + 1;
     }
+    sort(nodes.begin(), nodes.end(),
+         [](const auto &a, const auto &b) { return get<0>(a) < get<0>(b); });
+    auto find_node = [&nodes](size_t id) -> node* {
+        auto it = lower_bound(nodes.begin(), nodes.end(), id,
+                              [](const auto &a, size_t id) { return get<0>(a) < id; });
+        return it != nodes.end() && get<0>(*it) == id ? get<1>(*it) : nullptr;
+    };
     for (auto &p : nodes) {
-        node *n = get<0>(p.second);
+        node *n = get<1>(p);
         if (!n->is_leaf) {
-            n->left = get<0>(nodes[get<1>(p.second)]);
-            n->right = get<0>(nodes[get<2>(p.second)]);
+            n->left = find_node(get<2>(p));
+            n->right = find_node(get<3>(p));
         }
     }
-    root = get<0>(nodes[root_id]);
+    root = find_node(root_id);
+    compile();
+}
+
+void mllib::models::DecisionTree::load_from_stream(istream &in) {
+    string text, line;
+    while (getline(in, line, '\n')) {
+        if (is_blank(line.data(), line.data() + line.size()))
+            break;
+        text += line;
+        text += '\n';
+    }
+    parse(text.data(), text.data() + text.size());
 }
 
 void mllib::models::DecisionTree::load(const string &path) {
@@ -605,22 +1166,105 @@ void mllib::models::DecisionTree::load(const string &path) {
     in.close();
 }
 
+namespace {
+    const uint32_t TREE_HEADER = mllib::model_file::tag("DTHD");
+    // nodes of both precisions, "DTND" held both thresholds in one 24-byte node before
+    const uint32_t TREE_NODES = mllib::model_file::tag("DTN2");
+    const uint32_t TREE_NODES_F = mllib::model_file::tag("DTNF");
+    const uint32_t TREE_LEAF_LABELS = mllib::model_file::tag("DTLB");
+    const uint32_t TREE_CLASSES = mllib::model_file::tag("DTCL");
+    const uint32_t TREE_PROBABILITIES = mllib::model_file::tag("DTPB");
+    const uint32_t FOREST_HEADER = mllib::model_file::tag("RFHD");
+    const uint32_t FOREST_CRITERION = mllib::model_file::tag("RFCR");
+    const uint32_t FOREST_MAX_FEATURES = mllib::model_file::tag("RFMF");
+}
+
+void mllib::models::DecisionTree::save_binary(model_file::writer_t &writer, uint32_t index) const {
+    static_assert(sizeof(size_t) == sizeof(uint64_t), "Labels are stored as 64-bit values");
+    static_assert(sizeof(flat_node) == 16, "Nodes are stored without padding");
+    static_assert(sizeof(flat_node_f) == 12, "Single-precision nodes are stored without padding");
+    const vector<uint64_t> header = {max_depth, min_samples_leaf, min_samples_split, seed};
+    writer.add(TREE_HEADER, index, header);
+    writer.add(TREE_NODES, index, compiled.nodes, compiled.nodes_amount * sizeof(flat_node));
+    writer.add(TREE_NODES_F, index, compiled.nodes_f, compiled.nodes_amount * sizeof(flat_node_f));
+    writer.add(TREE_LEAF_LABELS, index, compiled.leaf_labels, compiled.leaves_amount * sizeof(size_t));
+    writer.add(TREE_CLASSES, index, compiled.classes, compiled.classes_amount * sizeof(size_t));
+    writer.add(TREE_PROBABILITIES, index, compiled.leaf_probabilities,
+               compiled.leaves_amount * compiled.classes_amount * sizeof(double));
+}
+
+bool mllib::models::DecisionTree::load_binary(const model_file::reader_t &reader, uint32_t index) {
+    size_t header_amount = 0, nodes_f_amount = 0, probabilities_amount = 0;
+    compiled_t view;
+    const uint64_t *header = reader.get<uint64_t>(TREE_HEADER, index, header_amount);
+    view.nodes = reader.get<flat_node>(TREE_NODES, index, view.nodes_amount);
+    view.nodes_f = reader.get<flat_node_f>(TREE_NODES_F, index, nodes_f_amount);
+    view.leaf_labels = reader.get<size_t>(TREE_LEAF_LABELS, index, view.leaves_amount);
+    view.classes = reader.get<size_t>(TREE_CLASSES, index, view.classes_amount);
+    view.leaf_probabilities = reader.get<double>(TREE_PROBABILITIES, index, probabilities_amount);
+    if (header == nullptr || header_amount != 4 || view.nodes == nullptr || view.nodes_amount == 0 ||
+        view.nodes_f == nullptr || nodes_f_amount != view.nodes_amount || view.leaf_labels == nullptr || view.classes == nullptr || view.leaf_probabilities == nullptr ||
+        probabilities_amount != view.leaves_amount * view.classes_amount)
+        return false;
+    // children always follow their parent in breadth-first order, so descent stops
+    for (size_t i = 0; i < view.nodes_amount; i++) {
+        const flat_node &flat = view.nodes[i];
+        if (flat.left == 0 ? flat.feature_idx >= view.leaves_amount :
+                flat.left <= i || size_t(flat.left) + 1 >= view.nodes_amount)
+            return false;
+        if (view.nodes_f[i].left != flat.left || view.nodes_f[i].feature_idx != flat.feature_idx)
+            return false;
+    }
+    delete root;
+    root = nullptr;
+    flat_nodes.clear();
+    flat_nodes_f.clear();
+    leaf_labels.clear();
+    classes.clear();
+    leaf_probabilities.clear();
+    max_depth = header[0];
+    min_samples_leaf = header[1];
+    min_samples_split = header[2];
+    seed = header[3];
+    eng = mt19937_64(seed);
+    compiled = view;
+    return true;
+}
+
 size_t mllib::models::DecisionTree::get_seed() const {
     return seed;
 }
 
+size_t mllib::models::DecisionTree::get_features_amount() const {
+    size_t amount = 0;
+    for (size_t i = 0; i < compiled.nodes_amount; i++)
+        if (compiled.nodes[i].left != 0)
+            amount = max(amount, size_t(compiled.nodes[i].feature_idx) + 1);
+    return amount;
+}
+
 void mllib::models::RandomForest::norm(map<size_t, double> &result) const {
     for (auto &p : result)
         p.second /= double(n_estimators);
 }
 
+namespace {
+    /// Share of bootstrap samples out of (0, 1], NaN included, is replaced by the whole data.
+    double valid_max_samples(double max_samples) {
+        return max_samples > 0.0 && max_samples <= 1.0 ? max_samples : 1.0;
+    }
+}
+
 mllib::models::RandomForest::RandomForest(size_t n_estimators,
                            size_t n_jobs,
                            size_t max_depth,
                            size_t min_samples_leaf,
                            size_t min_samples_split,
                            const string& criterion,
-                           const string& max_features) {
+                           const string& max_features,
+                           size_t max_bins,
+                           double max_samples,
+                           size_t seed) {
     this->n_estimators = n_estimators;
     this->n_jobs = n_jobs;
     this->max_depth = max_depth;
@@ -628,13 +1272,15 @@ mllib::models::RandomForest::RandomForest(size_t n_estimators,
     this->min_samples_split = min_samples_split;
     this->criterion = criterion;
     this->max_features = max_features;
+    this->max_bins = max_bins;
+    this->max_samples = valid_max_samples(max_samples);
+    if (seed == 0) {
+        random_device rd;
+        seed = rd();
+    }
+    this->seed = seed;
     this->trees.reserve(n_estimators);
-    this->seeds = new size_t[n_jobs];
-    random_device rd;
-    for (int i = 0; i < n_jobs; i++)
-        seeds[i] = rd();
-    seed_seq seed(seeds, seeds+n_jobs);
-    seed.generate(seeds, seeds+n_jobs);
+    reset_pool();
 }
 
 mllib::models::RandomForest::RandomForest(mllib::models::RandomForest &&m) noexcept :
@@ -645,8 +1291,16 @@ min_samples_leaf(m.min_samples_leaf),
 min_samples_split(m.min_samples_split),
 criterion(std::move(m.criterion)),
 max_features(std::move(m.max_features)),
+max_bins(m.max_bins),
+max_samples(m.max_samples),
+seed(m.seed),
+oob_score(m.oob_score),
+n_features(m.n_features),
+schema(m.schema),
 trees(std::move(m.trees)),
-seeds(m.seeds)
+class_labels(std::move(m.class_labels)),
+mapped(std::move(m.mapped)),
+pool(std::move(m.pool))
 {
     m.n_estimators = 0;
     m.n_jobs = 0;
@@ -655,12 +1309,14 @@ seeds(m.seeds)
     m.min_samples_split = 0;
     m.criterion.clear();
     m.max_features.clear();
+    m.max_bins = 0;
+    m.max_samples = 1.0;
+    m.seed = 0;
     m.trees.clear();
-    m.seeds = nullptr;
-}
-
-mllib::models::RandomForest::~RandomForest() {
-    delete seeds;
+    m.class_labels.clear();
+    m.oob_score = 0.0;
+    m.n_features = 0;
+    m.schema = 0;
 }
 
 mllib::models::RandomForest &mllib::models::RandomForest::operator=(mllib::models::RandomForest &&m) noexcept {
@@ -671,8 +1327,16 @@ mllib::models::RandomForest &mllib::models::RandomForest::operator=(mllib::model
     this->min_samples_split = m.min_samples_split;
     this->criterion = std::move(m.criterion);
     this->max_features = std::move(m.max_features);
+    this->max_bins = m.max_bins;
+    this->max_samples = m.max_samples;
+    this->seed = m.seed;
     this->trees = std::move(m.trees);
-    this->seeds = m.seeds;
+    this->class_labels = std::move(m.class_labels);
+    this->mapped = std::move(m.mapped);
+    this->pool = std::move(m.pool);
+    this->oob_score = m.oob_score;
+    this->n_features = m.n_features;
+    this->schema = m.schema;
     m.n_estimators = 0;
     m.n_jobs = 0;
     m.max_depth = 0;
@@ -680,8 +1344,14 @@ mllib::models::RandomForest &mllib::models::RandomForest::operator=(mllib::model
     m.min_samples_split = 0;
     m.criterion.clear();
     m.max_features.clear();
+    m.max_bins = 0;
+    m.max_samples = 1.0;
+    m.seed = 0;
     m.trees.clear();
-    m.seeds = nullptr;
+    m.class_labels.clear();
+    m.oob_score = 0.0;
+    m.n_features = 0;
+    m.schema = 0;
     return *this;
 }
 
@@ -692,92 +1362,194 @@ mllib::models::RandomForest* mllib::models::RandomForest::clone() {
                             min_samples_leaf,
                             min_samples_split,
                             criterion,
-                            max_features);
+                            max_features,
+                            max_bins,
+                            max_samples,
+                            seed);
+}
+
+void mllib::models::RandomForest::reset_pool() {
+    pool = n_jobs > 1 ? make_shared<TaskPool>(int(n_jobs)) : nullptr;
+}
+
+void mllib::models::RandomForest::set_pool(shared_ptr<TaskPool> other) {
+    pool = std::move(other);
+}
+
+void mllib::models::RandomForest::for_each_tree(size_t queries, const function<void(size_t)> &job) const {
+    if (pool == nullptr || n_estimators * queries < INLINE_QUERIES) {
+        for (size_t i = 0; i < n_estimators; i++)
+            job(i);
+        return;
+    }
+    TaskPool::group_t group;
+    for (size_t i = 1; i < n_estimators; i++)
+        pool->run(group, [&job, i] { job(i); });
+    job(0);
+    pool->wait(group);
 }
 
 void mllib::models::RandomForest::fit(Data &data) {
-    if (!trees.empty()) trees.clear();
-    ThreadPool pool(n_jobs);
-    for (int i = 0; i < n_estimators; i++) {
-        pool.add_job([&, i] {
-            DecisionTree tree(max_depth,
-                              min_samples_leaf,
-                              min_samples_split,
-                              criterion,
-                              max_features,
-                              seeds[i % n_jobs]);
-            tree.fit(data);
-            trees.emplace_back(std::move(tree));
+    // seeds of trees depend only on seed of forest, and every tree is written into its own slot,
+    // so the same forest comes out for any amount of jobs
+    vector<size_t> tree_seeds(n_estimators);
+    mt19937_64 master(seed);
+    // seed 0 would make tree draw random one
+    for (auto &tree_seed : tree_seeds)
+        do tree_seed = master(); while (tree_seed == 0);
+    trees.clear();
+    trees.resize(n_estimators);
+    n_features = data.features_size();
+    // features are quantized or sorted once for all trees
+    BinnedData binned;
+    SortedData sorted;
+    if (max_bins > 0)
+        binned = BinnedData(data, max_bins);
+    else
+        sorted = SortedData(data);
+    const size_t n = data.samples_size();
+    const size_t draws = max(size_t(1), size_t(max_samples * double(n)));
+    // votes of trees for samples out of their bootstraps, row per sample
+    vector<size_t> labels(n);
+    for (size_t i = 0; i < n; i++)
+        labels[i] = data.get_target(i);
+    sort(labels.begin(), labels.end());
+    labels.erase(unique(labels.begin(), labels.end()), labels.end());
+    vector<uint32_t> oob_votes(n * labels.size(), 0);
+    mutex oob_lock;
+    // trees and large nodes of trees share one pool, so small forest occupies all threads too
+    TaskPool own_pool(1);
+    TaskPool &fit_pool = pool != nullptr ? *pool : own_pool;
+    TaskPool::group_t group;
+    // every task fits trees one by one, so at most one tree per thread keeps its presorted samples,
+    // even when threads waiting for nodes of their trees take other tasks
+    atomic<size_t> next_tree(0);
+    auto fit_tree = [&](size_t i) {
+        DecisionTree tree(max_depth,
+                          min_samples_leaf,
+                          min_samples_split,
+                          criterion,
+                          max_features,
+                          tree_seeds[i],
+                          max_bins);
+        vector<uint32_t> weights = tree.draw_bootstrap(data, draws);
+        if (max_bins > 0)
+            tree.fit(data, binned, weights, &fit_pool);
+        else
+            tree.fit(data, sorted, weights, &fit_pool);
+        vector<pair<size_t, size_t>> votes;
+        for (size_t j = 0; j < n; j++)
+            if (weights[j] == 0) {
+                size_t label = tree.predict(j, data);
+                votes.emplace_back(j, size_t(lower_bound(labels.begin(), labels.end(), label) - labels.begin()));
+            }
+        {
+            lock_guard<mutex> lock(oob_lock);
+            for (auto &vote : votes)
+                oob_votes[vote.first * labels.size() + vote.second]++;
+        }
+        trees[i] = std::move(tree);
+    };
+    for (size_t t = 0; t < min(n_estimators, fit_pool.size()); t++)
+        fit_pool.run(group, [&] {
+            for (size_t i = next_tree++; i < n_estimators; i = next_tree++)
+                fit_tree(i);
         });
+    fit_pool.wait(group);
+    // majority of votes with the smallest label on ties, as in predict
+    size_t voted = 0, correct = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t *row = oob_votes.data() + i * labels.size();
+        size_t best = 0;
+        for (size_t c = 1; c < labels.size(); c++)
+            if (row[c] > row[best])
+                best = c;
+        if (labels.empty() || row[best] == 0) continue;
+        voted++;
+        correct += labels[best] == data.get_target(i);
+    }
+    oob_score = voted > 0 ? double(correct) / double(voted) : 0.0;
+    init_labels();
+}
+
+double mllib::models::RandomForest::get_oob_score() const {
+    return oob_score;
+}
+
+void mllib::models::RandomForest::init_labels() {
+    class_labels.clear();
+    for (const auto &tree : trees) {
+        vector<size_t> tree_labels = tree.get_labels();
+        class_labels.insert(class_labels.end(), tree_labels.begin(), tree_labels.end());
+    }
+    sort(class_labels.begin(), class_labels.end());
+    class_labels.erase(unique(class_labels.begin(), class_labels.end()), class_labels.end());
+}
+
+namespace {
+    /// Amount of labels whose votes are counted on stack.
+    const size_t STACK_LABELS = 16;
+}
+
+template <class TreeLabel>
+size_t mllib::models::RandomForest::vote(const TreeLabel &tree_label) const {
+    if (class_labels.empty()) return 0;
+    uint32_t stack_votes[STACK_LABELS] = {};
+    vector<uint32_t> heap_votes;
+    uint32_t *votes = stack_votes;
+    if (class_labels.size() > STACK_LABELS) {
+        heap_votes.assign(class_labels.size(), 0);
+        votes = heap_votes.data();
+    }
+    for (size_t j = 0; j < trees.size(); j++) {
+        size_t c = size_t(lower_bound(class_labels.begin(), class_labels.end(), tree_label(j)) - class_labels.begin());
+        if (c < class_labels.size())
+            votes[c]++;
     }
+    // the least label wins ties
+    size_t best = 0;
+    for (size_t c = 1; c < class_labels.size(); c++)
+        if (votes[c] > votes[best])
+            best = c;
+    return class_labels[best];
 }
 
 size_t mllib::models::RandomForest::predict(const std::vector<double> &query) {
-    vector<size_t> results;
-    results.reserve(n_estimators);
-    {
-        ThreadPool pool(n_jobs);
-        for (int i = 0; i < n_estimators; i++)
-            pool.add_job([&, i] { results.emplace_back(trees[i].predict(query)); });
-    }
-    map<size_t, size_t> class_cnt;
-    for (size_t j = 0; j < n_estimators; j++)
-        class_cnt[results[j]]++;
-    size_t max_cnt = 0, label = 0;
-    for (auto &p : class_cnt)
-        if (p.second > max_cnt) {
-            max_cnt = p.second;
-            label = p.first;
-        }
-    return label;
+    return vote([&](size_t j) { return trees[j].predict(query); });
 }
 
 void mllib::models::RandomForest::predict(Data &queries, vector<size_t> &result) {
     if (queries.samples_size() == 0) return;
-    vector<vector<size_t>> results;
-    results.reserve(n_estimators);
     size_t n_obj = queries.samples_size();
-    {
-        ThreadPool pool(n_jobs);
-        for (int i = 0; i < n_estimators; i++) {
-            pool.add_job([&, i] {
-                vector<size_t> tree_result(n_obj);
-                trees[i].predict(queries, tree_result);
-                results.emplace_back(tree_result);
-            });
-        }
-    }
-    map<size_t, size_t> class_cnt;
-    for (size_t i = 0; i < n_obj; i++) {
-        class_cnt.clear();
-        for (size_t j = 0; j < n_estimators; j++)
-            class_cnt[results[j][i]]++;
-        size_t max_cnt = 0, label = 0;
-        for (auto &p : class_cnt)
-            if (p.second > max_cnt) {
-                max_cnt = p.second;
-                label = p.first;
-            }
-        result[i] = label;
-    }
+    // every tree writes its own row, so jobs don't share containers
+    vector<vector<size_t>> results(n_estimators, vector<size_t>(n_obj));
+    for_each_tree(n_obj, [&](size_t i) { trees[i].predict(queries, results[i]); });
+    for (size_t i = 0; i < n_obj; i++)
+        result[i] = vote([&](size_t j) { return results[j][i]; });
+}
+
+size_t mllib::models::RandomForest::predict(const vector<float> &query) {
+    return vote([&](size_t j) { return trees[j].predict(query); });
+}
+
+void mllib::models::RandomForest::predict(const Matrix<float> &queries, vector<size_t> &result) {
+    size_t n_obj = queries.size().first;
+    if (n_obj == 0) return;
+    // every tree writes its own row, so jobs don't share containers
+    vector<vector<size_t>> results(n_estimators, vector<size_t>(n_obj));
+    for_each_tree(n_obj, [&](size_t i) { trees[i].predict(queries, results[i]); });
+    for (size_t i = 0; i < n_obj; i++)
+        result[i] = vote([&](size_t j) { return results[j][i]; });
 }
 
 void mllib::models::RandomForest::predict_prob(Data &queries, vector<map<size_t, double>> &probabilities) {
     if (queries.samples_size() == 0) return;
-    vector<vector<map<size_t, double>>> results;
     for (auto &dict : probabilities)
         if (!dict.empty()) dict.clear();
     size_t n_obj = queries.samples_size();
-    {
-        ThreadPool pool(n_jobs);
-        for (int i = 0; i < n_estimators; i++) {
-            pool.add_job([&, i] {
-                vector<map<size_t, double>> result(n_obj, map<size_t, double> ());
-                trees[i].predict_prob(queries, result);
-                results.emplace_back(result);
-            });
-        }
-    }
+    // every tree writes its own row and rows are summed in order of trees
+    vector<vector<map<size_t, double>>> results(n_estimators, vector<map<size_t, double>>(n_obj));
+    for_each_tree(n_obj, [&](size_t i) { trees[i].predict_prob(queries, results[i]); });
     size_t n = queries.samples_size();
     for (auto &res : results)
         for (size_t i = 0; i < n; i++)
@@ -794,6 +1566,23 @@ bool mllib::models::RandomForest::valid() const {
     return true;
 }
 
+size_t mllib::models::RandomForest::get_features_amount() const {
+    if (n_features > 0)
+        return n_features;
+    size_t amount = 0;
+    for (const auto &tree : trees)
+        amount = max(amount, tree.get_features_amount());
+    return amount;
+}
+
+void mllib::models::RandomForest::set_schema(uint64_t id) {
+    schema = id;
+}
+
+uint64_t mllib::models::RandomForest::get_schema() const {
+    return schema;
+}
+
 string mllib::models::RandomForest::get_saved_def() {
     stringstream ss;
     ss << "n_estimators=" << n_estimators << ',';
@@ -802,7 +1591,12 @@ string mllib::models::RandomForest::get_saved_def() {
     ss << "min_samples_leaf=" << min_samples_leaf << ',';
     ss << "min_samples_split=" << min_samples_split << ',';
     ss << "criterion=" << criterion << ',';
-    ss << "max_features=" << max_features << '\n';
+    ss << "max_features=" << max_features << ',';
+    ss << "max_bins=" << max_bins << ',';
+    ss << "max_samples=" << max_samples << ',';
+    ss << "seed=" << seed << ',';
+    ss << "n_features=" << n_features << ',';
+    ss << "schema=" << schema << '\n';
     size_t id = 0;
     for (auto &tree : trees) {
         ss << tree.get_saved_def();
@@ -820,62 +1614,71 @@ void mllib::models::RandomForest::save(const string &path, ios_base::openmode mo
     out.close();
 }
 
-void mllib::models::RandomForest::parse_header(const string &header) {
-    // Parse Tree header
-    const regex regex_n_estimators("n_estimators=([0-9]+)");
-    const regex regex_n_jobs("n_jobs=([0-9]+)");
-    const regex regex_max_depth("max_depth=([0-9]+)");
-    const regex regex_min_samples_leaf("min_samples_leaf=([0-9]+)");
-    const regex regex_min_samples_split("min_samples_split=([0-9]+)");
-    const regex regex_criterion("criterion=(\\w+)");
-    const regex regex_max_features("max_features=(\\w+)");
-    smatch match;
-    if (regex_search(header, match, regex_n_estimators)) {
-        n_estimators = stoull(match[1].str());
-        trees.reserve(n_estimators);
-    }
-    if (regex_search(header, match, regex_n_jobs)) {
-        n_jobs = stoull(match[1].str());
-        seeds = new size_t[n_jobs];
-    }
-    if (regex_search(header, match, regex_max_depth))
-        max_depth = stoull(match[1].str());
-    if (regex_search(header, match, regex_min_samples_leaf))
-        min_samples_leaf = stoull(match[1].str());
-    if (regex_search(header, match, regex_min_samples_split))
-        min_samples_split = stoull(match[1].str());
-    if (regex_search(header, match, regex_criterion))
-        criterion = match[1].str();
-    if (regex_search(header, match, regex_max_features))
-        max_features = match[1].str();
+void mllib::models::RandomForest::parse_header(const char *begin, const char *end) {
+    // Parse Tree header, amount and schema of features are absent in forests saved before they were recorded
+    n_features = 0;
+    schema = 0;
+    field_t field = {};
+    while (next_field(begin, end, field)) {
+        if (field.is("n_estimators")) {
+            n_estimators = to_size(field);
+            trees.reserve(n_estimators);
+        } else if (field.is("n_jobs"))
+            n_jobs = to_size(field);
+        else if (field.is("max_depth"))
+            max_depth = to_size(field);
+        else if (field.is("min_samples_leaf"))
+            min_samples_leaf = to_size(field);
+        else if (field.is("min_samples_split"))
+            min_samples_split = to_size(field);
+        else if (field.is("criterion"))
+            criterion = field.str();
+        else if (field.is("max_features"))
+            max_features = field.str();
+        else if (field.is("max_bins"))
+            max_bins = to_size(field);
+        else if (field.is("max_samples"))
+            max_samples = valid_max_samples(to_double(field));
+        else if (field.is("seed"))
+            seed = to_size(field);
+        else if (field.is("n_features"))
+            n_features = to_size(field);
+        else if (field.is("schema"))
+            schema = to_size(field);
+    }
 }
 
 void mllib::models::RandomForest::load_from_stream(istream &in) {
-    string line;
-    getline(in, line, '\n');
-    parse_header(line);
-    size_t i = 0;
-    int64_t last_pos = in.tellg();
-    while(getline(in, line, '\n')) {
-        smatch match;
-        if (regex_match(line, match, regex("^\\s*$"))) {
-            last_pos = in.tellg();
-        }
-        in.seekg(last_pos);
-        i++;
-        DecisionTree tree;
-        tree.load_from_stream(in);
-        trees.emplace_back(std::move(tree));
-        if (i == n_estimators)
-            break;
-    }
-    random_device rd;
-            for (int id = 0; id < n_jobs; id++) {
-        if (id < n_estimators)
-            seeds[id] = trees[id].get_seed();
-        else
-            seeds[id] = rd();
+    const string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    const char *pos = text.data(), *end = text.data() + text.size();
+    const char *header_end = line_end(pos, end);
+    parse_header(pos, header_end);
+    reset_pool();
+    // trees are separated by blank lines
+    vector<pair<const char *, const char *>> blocks;
+    const char *block = nullptr;
+    for (pos = header_end; pos != end && blocks.size() < n_estimators;) {
+        const char *begin = pos + 1, *finish = line_end(begin, end);
+        if (is_blank(begin, finish)) {
+            if (block != nullptr)
+                blocks.emplace_back(block, begin);
+            block = nullptr;
+        } else if (block == nullptr)
+            block = begin;
+        pos = finish;
     }
+    if (block != nullptr && blocks.size() < n_estimators)
+        blocks.emplace_back(block, end);
+    vector<DecisionTree> loaded(blocks.size());
+    TaskPool own_pool(1);
+    TaskPool &parse_pool = pool != nullptr ? *pool : own_pool;
+    TaskPool::group_t group;
+    for (size_t i = 0; i < blocks.size(); i++)
+        parse_pool.run(group, [&, i] { loaded[i].parse(blocks[i].first, blocks[i].second); });
+    parse_pool.wait(group);
+    for (auto &tree : loaded)
+        trees.emplace_back(std::move(tree));
+    init_labels();
 }
 
 void mllib::models::RandomForest::load(const string &path) {
@@ -884,4 +1687,87 @@ void mllib::models::RandomForest::load(const string &path) {
         load_from_stream(in);
     }
     in.close();
-}
\ No newline at end of file
+}
+
+void mllib::models::RandomForest::save_binary(model_file::writer_t &writer) const {
+    uint64_t max_samples_bits;
+    memcpy(&max_samples_bits, &max_samples, sizeof(max_samples_bits));
+    const vector<uint64_t> header = {n_estimators, n_jobs, max_depth, min_samples_leaf, min_samples_split, max_bins, seed,
+                                     max_samples_bits, n_features, schema};
+    writer.add(FOREST_HEADER, 0, header);
+    writer.add(FOREST_CRITERION, 0, criterion.data(), criterion.size());
+    writer.add(FOREST_MAX_FEATURES, 0, max_features.data(), max_features.size());
+    for (size_t i = 0; i < trees.size(); i++)
+        trees[i].save_binary(writer, uint32_t(i));
+}
+
+bool mllib::models::RandomForest::load_binary(shared_ptr<const model_file::reader_t> reader) {
+    if (reader == nullptr || !reader->valid()) return false;
+    size_t header_amount = 0, criterion_size = 0, max_features_size = 0;
+    const uint64_t *header = reader->get<uint64_t>(FOREST_HEADER, 0, header_amount);
+    const char *criterion_name = reader->get<char>(FOREST_CRITERION, 0, criterion_size);
+    const char *max_features_name = reader->get<char>(FOREST_MAX_FEATURES, 0, max_features_size);
+    // amount of bins, seed, share of bootstrap samples, amount and schema of features are absent in containers
+    // written before histogram training, seeded fit, bagging and feature schema
+    if (header == nullptr || header_amount < 5 || header_amount > 10 || header[1] == 0 ||
+        criterion_name == nullptr || max_features_name == nullptr)
+        return false;
+    vector<DecisionTree> loaded(header[0]);
+    for (size_t i = 0; i < loaded.size(); i++)
+        if (!loaded[i].load_binary(*reader, uint32_t(i)))
+            return false;
+    n_estimators = header[0];
+    n_jobs = header[1];
+    max_depth = header[2];
+    min_samples_leaf = header[3];
+    min_samples_split = header[4];
+    max_bins = header_amount > 5 ? header[5] : 0;
+    if (header_amount > 6)
+        seed = header[6];
+    max_samples = 1.0;
+    if (header_amount > 7)
+        memcpy(&max_samples, &header[7], sizeof(max_samples));
+    max_samples = valid_max_samples(max_samples);
+    n_features = header_amount > 8 ? header[8] : 0;
+    schema = header_amount > 9 ? header[9] : 0;
+    criterion.assign(criterion_name, criterion_size);
+    max_features.assign(max_features_name, max_features_size);
+    trees = std::move(loaded);
+    init_labels();
+    mapped = std::move(reader);
+    reset_pool();
+    return true;
+}
+
+void mllib::models::RandomForest::generate_code(ostream &out, const string &name) const {
+    vector<size_t> labels = class_labels;
+    if (labels.empty()) labels.push_back(0);
+    out << "// Generated from random forest with " << trees.size() << " trees, don't edit.\n";
+    out << "#include <cstddef>\n#include <limits>\n\n";
+    for (size_t i = 0; i < trees.size(); i++) {
+        trees[i].generate_code(out, name + "_tree_" + to_string(i), labels);
+        out << '\n';
+    }
+    out << "size_t " << name << "(const float *x) {\n";
+    out << "    static const size_t labels[" << labels.size() << "] = {";
+    for (size_t i = 0; i < labels.size(); i++)
+        out << (i > 0 ? ", " : "") << labels[i];
+    out << "};\n";
+    out << "    size_t votes[" << labels.size() << "] = {};\n";
+    for (size_t i = 0; i < trees.size(); i++)
+        out << "    votes[" << name << "_tree_" << i << "(x)]++;\n";
+    // the least label wins ties, as in predict
+    out << "    size_t best = 0;\n";
+    out << "    for (size_t i = 1; i < " << labels.size() << "; i++)\n";
+    out << "        if (votes[i] > votes[best])\n";
+    out << "            best = i;\n";
+    out << "    return labels[best];\n";
+    out << "}\n";
+}
+
+void mllib::models::RandomForest::generate_code(const string &path, const string &name) const {
+    ofstream out(path, ios::out);
+    if (out.is_open())
+        generate_code(out, name);
+    out.close();
+}
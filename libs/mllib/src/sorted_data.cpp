@@ -0,0 +1,41 @@
+//
+// Created by Alex Shchelochkov on 19.10.2026.
+//
+
+#include "../include/sorted_data.hpp"
+
+using namespace std;
+
+mllib::SortedData::SortedData(const Data &data) :
+samples_amount(data.samples_size()),
+features_amount(data.features_size())
+{
+    order.resize(samples_amount * features_amount);
+    values.resize(samples_amount * features_amount);
+    vector<pair<double, uint32_t>> column(samples_amount);
+    for (size_t f = 0; f < features_amount; f++) {
+        for (size_t i = 0; i < samples_amount; i++)
+            column[i] = {data.get_feature(i, f), uint32_t(i)};
+        sort(column.begin(), column.end());
+        for (size_t i = 0; i < samples_amount; i++) {
+            values[f * samples_amount + i] = column[i].first;
+            order[f * samples_amount + i] = column[i].second;
+        }
+    }
+}
+
+size_t mllib::SortedData::samples_size() const {
+    return samples_amount;
+}
+
+size_t mllib::SortedData::features_size() const {
+    return features_amount;
+}
+
+const uint32_t *mllib::SortedData::get_order(size_t column) const {
+    return order.data() + column * samples_amount;
+}
+
+const double *mllib::SortedData::get_values(size_t column) const {
+    return values.data() + column * samples_amount;
+}
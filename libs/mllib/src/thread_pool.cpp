@@ -6,6 +6,12 @@
 
 using namespace std;
 
+namespace {
+    /// Pool and deque of current worker.
+    thread_local const mllib::TaskPool *worker_pool = nullptr;
+    thread_local size_t worker_queue = 0;
+}
+
 mllib::ThreadPool::ThreadPool(int threads_cnt) : _shutdown(false) {
     _threads.reserve(threads_cnt);
     for (int i = 0; i < threads_cnt; i++)
@@ -43,4 +49,90 @@ void mllib::ThreadPool::add_job(job _job) {
     unique_lock<mutex> _unique_lock(_lock);
     _jobs.emplace(_job);
     _cond_var.notify_one();
-}
\ No newline at end of file
+}
+mllib::TaskPool::TaskPool(int threads_cnt) {
+    size_t workers = size_t(max(threads_cnt, 1) - 1);
+    for (size_t i = 0; i <= workers; i++)
+        _queues.emplace_back(new queue_t());
+    _threads.reserve(workers);
+    for (size_t i = 0; i < workers; i++)
+        _threads.emplace_back([this, i] { thread_work(i); });
+}
+
+mllib::TaskPool::~TaskPool() {
+    {
+        unique_lock<mutex> _unique_lock(_lock);
+        _shutdown = true;
+        _cond_var.notify_all();
+    }
+    for (auto &thread : _threads)
+        thread.join();
+}
+
+size_t mllib::TaskPool::size() const {
+    return _threads.size() + 1;
+}
+
+size_t mllib::TaskPool::own_queue() const {
+    return worker_pool == this ? worker_queue : _queues.size() - 1;
+}
+
+bool mllib::TaskPool::run_one(size_t queue_id) {
+    pair<job, group_t *> task;
+    bool found = false;
+    {
+        queue_t &own = *_queues[queue_id];
+        lock_guard<mutex> _lock_guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (size_t i = 1; !found && i < _queues.size(); i++) {
+        queue_t &other = *_queues[(queue_id + i) % _queues.size()];
+        lock_guard<mutex> _lock_guard(other.lock);
+        if (!other.tasks.empty()) {
+            task = move(other.tasks.front());
+            other.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) return false;
+    _queued--;
+    task.first();
+    task.second->_pending--;
+    return true;
+}
+
+void mllib::TaskPool::thread_work(size_t id) {
+    worker_pool = this;
+    worker_queue = id;
+    while (true) {
+        if (run_one(id)) continue;
+        unique_lock<mutex> _unique_lock(_lock);
+        while (!_shutdown && _queued == 0)
+            _cond_var.wait(_unique_lock);
+        if (_shutdown && _queued == 0)
+            return;
+    }
+}
+
+void mllib::TaskPool::run(group_t &group, job _job) {
+    group._pending++;
+    {
+        queue_t &queue = *_queues[own_queue()];
+        lock_guard<mutex> _lock_guard(queue.lock);
+        queue.tasks.emplace_back(move(_job), &group);
+    }
+    _queued++;
+    lock_guard<mutex> _lock_guard(_lock);
+    _cond_var.notify_one();
+}
+
+void mllib::TaskPool::wait(group_t &group) {
+    size_t queue_id = own_queue();
+    while (group._pending > 0)
+        if (!run_one(queue_id))
+            this_thread::yield();
+}
@@ -4,9 +4,30 @@
 
 #include "../include/MainUtils.hpp"
 
+#include <chrono>
+#include <malloc.h>
+
 using namespace std;
 using namespace frameslib;
 
+namespace {
+    /// Start measuring peak resident memory of process anew, it works on Linux only.
+    void resetPeakMemory() {
+        // freed memory of previous measurements is returned to system first
+        malloc_trim(0);
+        ofstream("/proc/self/clear_refs") << "5";
+    }
+    /// Peak resident memory of process in megabytes, 0 if it's unknown.
+    double getPeakMemory() {
+        ifstream in("/proc/self/status");
+        string line;
+        while (getline(in, line))
+            if (line.rfind("VmHWM:", 0) == 0)
+                return stod(line.substr(6)) / 1024.0;
+        return 0.0;
+    }
+}
+
 void WiFiClassifier::getStatistics(vector<frames::LogFrame> &frames) {
     frames::statistics::Statistics stat(frames);
     cout << stat.toString() << '\n';
@@ -204,6 +225,232 @@ void WiFiClassifier::workWithDataFrames(vector<frames::LogFrame> &frames) {
 //    printToFile("../data/data_tmp.log", DS, 2);
 }
 
+void WiFiClassifier::validateSketchFeatures(vector<frames::LogFrame> &frames) {
+    mllib::models::RandomForest model;
+    model.load(".." + global_vars::modelParamsPath);
+    if (!model.valid()) {
+        cerr << "Can't load model: " << global_vars::modelParamsPath << '\n';
+        return;
+    }
+    // collect transmissions to packets grouped by TA
+    map<uint64_t, vector<packet::Packet>> D = packet::collectPacketsByTA(frames);
+    // cut first "MTU" packets from begin and save not more than 200 packets
+    map<uint64_t, vector<packet::Packet>> SM = cutFirstMTUPackets(D, global_vars::packetsAmountThreshold);
+    // indexes of median and MAD of sizes and intervals
+    const vector<size_t> medianIds = {6, 7, 18, 19};
+    vector<double> maxError(medianIds.size(), 0.0);
+    size_t total = 0, agreed = 0;
+    for (auto &p : SM) {
+        if (p.second.size() < global_vars::packetsAmountThreshold)
+            continue;
+        vector<double> exact = features::excludeFeaturesFromPackets(p.second);
+        features::StreamingFeatures stream;
+        stream.addPackets(packet::PacketHistory(p.second));
+        vector<double> approx = stream.getFeatures();
+        if (count_if(exact.begin(), exact.end(), [](double x) { return isnan(x); }) > 0 ||
+            count_if(approx.begin(), approx.end(), [](double x) { return isnan(x); }) > 0)
+            continue;
+        for (size_t i = 0; i < medianIds.size(); i++) {
+            double x = exact[medianIds[i]], y = approx[medianIds[i]];
+            maxError[i] = max(maxError[i], x == 0 ? fabs(y) : fabs(y - x) / fabs(x));
+        }
+        total++;
+        if (model.predict(exact) == model.predict(approx))
+            agreed++;
+    }
+    cout << "objects: " << total << '\n'
+         << "same prediction: " << (total == 0 ? 1.0 : double(agreed) / double(total)) << '\n'
+         << "max relative error of median, MAD of sizes and intervals: " << utils::vectorToString(maxError) << '\n';
+}
+
+void WiFiClassifier::validateSinglePrecision(vector<frames::LogFrame> &frames) {
+    mllib::models::RandomForest model;
+    model.load(".." + global_vars::modelParamsPath);
+    transformer_t transformer(".." + global_vars::transformerPath);
+    if (!model.valid()) {
+        cerr << "Can't load model: " << global_vars::modelParamsPath << '\n';
+        return;
+    }
+    map<uint64_t, vector<packet::Packet>> D = packet::collectPacketsByTA(frames);
+    map<uint64_t, vector<packet::Packet>> SM = cutFirstMTUPackets(D, global_vars::packetsAmountThreshold);
+    size_t total = 0, agreed = 0, observations = 0, sameObservations = 0;
+    double maxError = 0.0;
+    vector<double> exact(global_vars::ObservationFeatures::size);
+    vector<float> approx(global_vars::ObservationFeatures::size);
+    for (auto &p : SM) {
+        packet::PacketHistory history(p.second);
+        if (history.size() >= global_vars::packetsAmountThreshold) {
+            vector<double> ftrs = global_vars::PacketFeatures::extract(history);
+            vector<float> ftrs_f(global_vars::PacketFeatures::size);
+            global_vars::PacketFeatures::extract(history, ftrs_f.data());
+            for (size_t i = 0; i < ftrs.size(); i++)
+                if (!isnan(ftrs[i]) && ftrs[i] != 0)
+                    maxError = max(maxError, fabs(double(ftrs_f[i]) - ftrs[i]) / fabs(ftrs[i]));
+            total++;
+            if (model.predict(ftrs) == model.predict(ftrs_f))
+                agreed++;
+        }
+        // observations of every prefix as probability model sees them
+        features::PrefixFeatureEngine engine(history);
+        while (engine.next()) {
+            engine.getFeatures<global_vars::ObservationFeatures>(exact.data());
+            engine.getFeatures<global_vars::ObservationFeatures>(approx.data());
+            observations++;
+            if (transformer.calc_observation(exact) == transformer.calc_observation(approx))
+                sameObservations++;
+        }
+    }
+    cout << "objects: " << total << '\n'
+         << "same prediction: " << (total == 0 ? 1.0 : double(agreed) / double(total)) << '\n'
+         << "max relative error of features: " << maxError << '\n'
+         << "observations: " << observations << '\n'
+         << "same observation: " << (observations == 0 ? 1.0 : double(sameObservations) / double(observations)) << '\n';
+}
+
+void WiFiClassifier::benchmarkForestFit(const vector<size_t> &jobs, size_t n_estimators, size_t max_bins) {
+    mllib::Data data;
+    data.read(".." + global_vars::modelDataPath);
+    if (data.samples_size() == 0) {
+        cerr << "Can't load data: " << global_vars::modelDataPath << '\n';
+        return;
+    }
+    // speedup is bounded by cores, not by requested jobs
+    cout << "samples: " << data.samples_size() << ", features: " << data.features_size()
+         << ", hardware threads: " << thread::hardware_concurrency() << '\n';
+    double firstTime = 0.0;
+    string firstModel;
+    for (size_t n_jobs : jobs) {
+        mllib::models::RandomForest model(n_estimators, n_jobs, 0, 1, 2, "gini", "sqrt", max_bins, 1.0, 42);
+        model.set_schema(global_vars::PacketFeatures::hash());
+        resetPeakMemory();
+        auto start = chrono::steady_clock::now();
+        model.fit(data);
+        double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        string def = model.get_saved_def();
+        // n_jobs is a part of saved header
+        def = def.substr(def.find('\n'));
+        if (firstModel.empty()) {
+            firstTime = time;
+            firstModel = def;
+        }
+        cout << "n_jobs: " << n_jobs
+             << ", fit time: " << time << " s"
+             << ", speedup: " << firstTime / time
+             << ", peak memory: " << getPeakMemory() << " MB"
+             << ", OOB score: " << model.get_oob_score()
+             << ", same forest: " << (def == firstModel ? "yes" : "no") << '\n';
+    }
+}
+
+void WiFiClassifier::benchmarkFrameReading(const string &path, const vector<size_t> &threads, bool oldFileFormat) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        cerr << "Can't read file: " << path << '\n';
+        return;
+    }
+    const string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    // speedup is bounded by cores, not by requested threads
+    cout << "size: " << double(text.size()) / 1024.0 / 1024.0 << " MB"
+         << ", hardware threads: " << thread::hardware_concurrency() << '\n';
+    double firstTime = 0.0;
+    vector<tuple<double, size_t, uint64_t>> firstReady;
+    for (size_t n_threads : threads) {
+        frames::syncworker::SyncFrameWorker worker(int(n_threads), global_vars::packetsAmountThreshold);
+        queue<frames::syncworker::SyncPacketWorker *> ready;
+        istringstream stream(text);
+        auto start = chrono::steady_clock::now();
+        worker.readFramesFromStream(stream, ready, oldFileFormat);
+        double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        // ready workers come in order of threads, so they are compared by their packets
+        vector<tuple<double, size_t, uint64_t>> packets;
+        for (; !ready.empty(); ready.pop()) {
+            const packet::PacketHistory &history = ready.front()->getHistory();
+            uint64_t sizes = accumulate(history.getSizes().begin(), history.getSizes().end(), uint64_t(0));
+            packets.emplace_back(history.empty() ? 0.0 : history.getOffsets()[0], history.size(), sizes);
+        }
+        sort(packets.begin(), packets.end());
+        if (firstReady.empty() && firstTime == 0.0) {
+            firstTime = time;
+            firstReady = packets;
+        }
+        cout << "threads: " << n_threads
+             << ", read time: " << time << " s"
+             << ", throughput: " << double(text.size()) / 1024.0 / 1024.0 / time << " MB/s"
+             << ", speedup: " << firstTime / time
+             << ", ready: " << packets.size()
+             << ", same packets: " << (packets == firstReady ? "yes" : "no") << '\n';
+    }
+}
+
+bool WiFiClassifier::generateModelCode() {
+    mllib::models::RandomForest model;
+    model.load(".." + global_vars::modelParamsPath);
+    if (!model.valid()) {
+        cerr << "Can't load model: " << global_vars::modelParamsPath << '\n';
+        return false;
+    }
+    model.generate_code(".." + global_vars::generatedModelPath);
+    return true;
+}
+
+bool WiFiClassifier::validateGeneratedModel(size_t (*predict)(const float *)) {
+    mllib::models::RandomForest model;
+    model.load(".." + global_vars::modelParamsPath);
+    if (!model.valid()) {
+        cerr << "Can't load model: " << global_vars::modelParamsPath << '\n';
+        return false;
+    }
+    mllib::Data data;
+    data.read(".." + global_vars::modelDataPath);
+    size_t n = data.samples_size(), sameFloat = 0, sameDouble = 0;
+    vector<double> row(data.features_size());
+    vector<float> row_f(data.features_size());
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < row.size(); j++) {
+            row[j] = data.get_feature(i, j);
+            row_f[j] = float(row[j]);
+        }
+        size_t label = predict(row_f.data());
+        if (label == model.predict(row_f))
+            sameFloat++;
+        if (label == model.predict(row))
+            sameDouble++;
+    }
+    cout << "samples: " << n << '\n'
+         << "same as float model: " << sameFloat << '\n'
+         << "same as double model: " << sameDouble << '\n';
+    return sameFloat == n;
+}
+
+bool WiFiClassifier::convertModelsToBinary() {
+    mllib::models::RandomForest model;
+    model.load(".." + global_vars::modelParamsPath);
+    if (!model.valid()) {
+        cerr << "Can't load model: " << global_vars::modelParamsPath << '\n';
+        return false;
+    }
+    transformer_t transformer(".." + global_vars::transformerPath);
+    if (transformer.features_amount() == 0) {
+        cerr << "Can't load transformer: " << global_vars::transformerPath << '\n';
+        return false;
+    }
+    // text forests saved without schema were trained on all features in their order
+    if (model.get_schema() == 0 && model.get_features_amount() == global_vars::PacketFeatures::size)
+        model.set_schema(global_vars::PacketFeatures::hash());
+    ProbModel probModel;
+    probModel.load(".." + global_vars::probabilityModelPath);
+    mllib::model_file::writer_t writer;
+    model.save_binary(writer);
+    transformer.save_binary(writer);
+    probModel.save_binary(writer);
+    if (!writer.save(".." + global_vars::binaryModelsPath)) {
+        cerr << "Can't write models: " << global_vars::binaryModelsPath << '\n';
+        return false;
+    }
+    return true;
+}
+
 void
 WiFiClassifier::workWithDefiniteFile(const string &path,
                                      const function<void(vector<frames::LogFrame> &)> &action) {
@@ -19,6 +19,11 @@ standard_scale_t::standard_scale_t(istream &in) {
     load(in);
 }
 
+standard_scale_t::standard_scale_t(vector<double> means, vector<double> stds) :
+means(std::move(means)),
+stds(std::move(stds))
+{}
+
 void standard_scale_t::save(std::ostream &out) const {
     out << "means=[" << frameslib::utils::vectorToString(means, ", ") << "]\n";
     out << "stds=[" << frameslib::utils::vectorToString(stds, ", ") << "]\n";
@@ -97,6 +102,18 @@ vector<double> standard_scale_t::inverse_transform(const vector<double> &v) cons
     return res;
 }
 
+size_t standard_scale_t::size() const {
+    return means.size();
+}
+
+const vector<double> &standard_scale_t::get_means() const {
+    return means;
+}
+
+const vector<double> &standard_scale_t::get_stds() const {
+    return stds;
+}
+
 transformer_t::transformer_t(const string &states_path,
                              const string &observations_path,
                              const string &means_path,
@@ -127,6 +144,7 @@ transformer_t::transformer_t(const string &states_path,
             states.emplace_back(stoul(x));
     }
     sts_in.close();
+    init_single_precision();
 }
 
 transformer_t::transformer_t(const std::string &path) {
@@ -152,6 +170,17 @@ transformer_t::transformer_t(const std::string &path) {
         }
     }
     in.close();
+    init_single_precision();
+}
+
+void transformer_t::init_single_precision() {
+    means_f.assign(scale.get_means().begin(), scale.get_means().end());
+    stds_f.assign(scale.get_stds().begin(), scale.get_stds().end());
+    size_t n_ftrs = observations.empty() ? 0 : observations[0].size();
+    observations_f = Matrix<float>(observations.size(), n_ftrs);
+    for (size_t i = 0; i < observations.size(); i++)
+        for (size_t j = 0; j < n_ftrs && j < observations[i].size(); j++)
+            observations_f(i, j) = float(observations[i][j]);
 }
 
 void transformer_t::save(ostream &out) const {
@@ -169,6 +198,73 @@ void transformer_t::save(const std::string &path) const {
     out.close();
 }
 
+namespace {
+    const uint32_t SCALE_MEANS = model_file::tag("SCMN");
+    const uint32_t SCALE_STDS = model_file::tag("SCSD");
+    const uint32_t TRANSFORMER_STATES = model_file::tag("TRST");
+    const uint32_t TRANSFORMER_SIZE = model_file::tag("TRSZ");
+    const uint32_t TRANSFORMER_CENTERS = model_file::tag("TRCN");
+
+    /**
+     * Write features of streaming device, its raw tail is streamed into copy of its features.
+     *
+     * @param obj streaming device;
+     * @param out row of `PacketFeatures`.
+     */
+    template <typename T>
+    void writeStreamingFeatures(const object::PacketClassifiedObject &obj, T *out) {
+        features::StreamingFeatures stream = *obj.getStream();
+        stream.addPackets(obj.getHistory());
+        stream.getFeatures<global_vars::PacketFeatures>(out);
+    }
+
+    /**
+     * Check that forest was trained on features of `PacketFeatures` in their order.
+     * Forests saved without schema can only be checked by amount of features.
+     *
+     * @param estimator forest.
+     *
+     * @return whether forest's schema or, for legacy forests, amount of features matches.
+     */
+    bool fitsPacketFeatures(const PacketEstimator &estimator) {
+        if (estimator.get_schema() != 0)
+            return estimator.get_schema() == global_vars::PacketFeatures::hash();
+        return estimator.get_features_amount() == global_vars::PacketFeatures::size;
+    }
+}
+
+void transformer_t::save_binary(model_file::writer_t &writer) const {
+    size_t n_ftrs = observations.empty() ? 0 : observations[0].size();
+    const vector<uint64_t> sizes = {observations.size(), n_ftrs};
+    vector<double> centers;
+    centers.reserve(observations.size() * n_ftrs);
+    for (const auto& v : observations)
+        centers.insert(centers.end(), v.begin(), v.end());
+    writer.add(SCALE_MEANS, 0, scale.get_means());
+    writer.add(SCALE_STDS, 0, scale.get_stds());
+    writer.add(TRANSFORMER_STATES, 0, states);
+    writer.add(TRANSFORMER_SIZE, 0, sizes);
+    writer.add(TRANSFORMER_CENTERS, 0, centers);
+}
+
+bool transformer_t::load_binary(const model_file::reader_t &reader) {
+    vector<double> means, stds, centers;
+    vector<size_t> new_states;
+    vector<uint64_t> sizes;
+    if (!reader.read(SCALE_MEANS, 0, means) || !reader.read(SCALE_STDS, 0, stds) ||
+        !reader.read(TRANSFORMER_STATES, 0, new_states) || !reader.read(TRANSFORMER_SIZE, 0, sizes) ||
+        !reader.read(TRANSFORMER_CENTERS, 0, centers) ||
+        means.size() != stds.size() || sizes.size() != 2 || centers.size() != sizes[0] * sizes[1])
+        return false;
+    scale = standard_scale_t(std::move(means), std::move(stds));
+    states = std::move(new_states);
+    observations.assign(sizes[0], {});
+    for (size_t i = 0; i < observations.size(); i++)
+        observations[i].assign(centers.begin() + i * sizes[1], centers.begin() + (i + 1) * sizes[1]);
+    init_single_precision();
+    return true;
+}
+
 size_t transformer_t::calc_observation(const vector<double> &ftrs) const {
     // return special observation for NaN (state is AP)
     if (std::any_of(ftrs.begin(), ftrs.end(), [](auto x) { return isnan(x); }))
@@ -186,10 +282,40 @@ size_t transformer_t::calc_observation(const vector<double> &ftrs) const {
     return res;
 }
 
+size_t transformer_t::calc_observation(const vector<float> &ftrs) const {
+    // return special observation for NaN (state is AP)
+    if (std::any_of(ftrs.begin(), ftrs.end(), [](auto x) { return isnan(x); }))
+        return observations.size();
+    size_t n = ftrs.size();
+    if (n != means_f.size() || n != stds_f.size() || n != observations_f.size().second)
+        return observations.size();
+    vector<float> scaled_ftrs(n);
+    for (size_t i = 0; i < n; i++)
+        scaled_ftrs[i] = (ftrs[i] - means_f[i]) / stds_f[i];
+    // squared distance keeps the order of euclidean one
+    size_t res = observations.size();
+    float m = FLT_MAX;
+    for (size_t i = 0; i < observations.size(); i++) {
+        const float *center = observations_f.at(i, 0);
+        float dist = 0;
+        for (size_t j = 0; j < n; j++)
+            dist += (scaled_ftrs[j] - center[j]) * (scaled_ftrs[j] - center[j]);
+        if (dist < m) {
+            res = i;
+            m = dist;
+        }
+    }
+    return res;
+}
+
 bool transformer_t::is_special(size_t observation) const {
     return observation == observations.size();
 }
 
+size_t transformer_t::features_amount() const {
+    return scale.size();
+}
+
 
 WiFiHandler::WiFiHandler(unique_ptr<MACPredefindEstimator> macClassifier,
                          unique_ptr<PacketEstimator> packetEstimator,
@@ -197,12 +323,10 @@ WiFiHandler::WiFiHandler(unique_ptr<MACPredefindEstimator> macClassifier,
                          unique_ptr<ProbModel> probModel)
 : macClassifier(std::move(macClassifier)) {
     network = this->macClassifier->getNetwork();
-    worker = make_unique<frames::worker::Worker>(global_vars::packetsAmountThreshold);
-    if (packetEstimator != nullptr)
-        packetClassifier = std::move(packetEstimator);
-    else {
+    macs = make_shared<object::MacTable>();
+    worker = make_unique<frames::worker::Worker>(global_vars::packetsAmountThreshold, macs);
+    if (packetEstimator == nullptr || !setPacketClassifier(std::move(packetEstimator)))
         packetClassifier = std::make_unique<PacketEstimator>();
-    }
 }
 
 WiFiHandler::~WiFiHandler() {
@@ -214,7 +338,15 @@ WiFiHandler& WiFiHandler::operator=(WiFiHandler&& other) noexcept {
     this->macClassifier = std::move(other.macClassifier);
     this->packetClassifier = std::move(other.packetClassifier);
     this->worker = std::move(other.worker);
+    this->macs = std::move(other.macs);
     this->alreadyClassified = std::move(other.alreadyClassified);
+    this->observationCache = std::move(other.observationCache);
+    this->dirtyObjects = std::move(other.dirtyObjects);
+    this->freshlyClassified = std::move(other.freshlyClassified);
+    this->classifiedObjects = std::move(other.classifiedObjects);
+    this->notClassifiedObjects = std::move(other.notClassifiedObjects);
+    this->allObjects = std::move(other.allObjects);
+    this->singlePrecision = other.singlePrecision;
     return *this;
 }
 
@@ -223,8 +355,12 @@ void WiFiHandler::setMACEstimator(unique_ptr<MACPredefindEstimator> macClassifie
     this->network = this->macClassifier->getNetwork();
 }
 
-void WiFiHandler::setPacketClassifier(unique_ptr<PacketEstimator> estimator) {
+bool WiFiHandler::setPacketClassifier(unique_ptr<PacketEstimator> estimator) {
+    // forest must be trained on exactly the features of schema, not only use no more of them
+    if (estimator == nullptr || !fitsPacketFeatures(*estimator))
+        return false;
     this->packetClassifier = std::move(estimator);
+    return true;
 }
 
 void WiFiHandler::handleFrame(uint64_t ind_v, double Offset_v, uint32_t Size_v,
@@ -237,29 +373,137 @@ void WiFiHandler::handleFrame(uint64_t ind_v, double Offset_v, uint32_t Size_v,
                       "", FCS_v, std::move(Type_v), std::move(SSID_v), TA_v, RA_v, moreFragments_v, seqNum_v, fragNum_v));
 }
 
-vector<size_t> WiFiHandler::getObservations(const shared_ptr<object::PacketClassifiedObject> &obj) {
-    auto packs = obj->getPackets();
-    vector<size_t> O;
-    O.reserve(packs.size());
-    for (size_t sz = 1; sz <= packs.size(); sz++) {
-        vector<packet::Packet> v(packs.begin(), packs.begin()+sz);
-        auto ftrs =  features::excludeFeaturesFromPacketsWithSkips(v, global_vars::skippedFeatures);
-        O.emplace_back(transformer->calc_observation(ftrs));
+template <class Features>
+size_t WiFiHandler::observe(const Features &ftrs) const {
+    if (singlePrecision) {
+        vector<float> buf(global_vars::ObservationFeatures::size);
+        ftrs.template getFeatures<global_vars::ObservationFeatures>(buf.data());
+        return transformer->calc_observation(buf);
+    }
+    vector<double> buf(global_vars::ObservationFeatures::size);
+    ftrs.template getFeatures<global_vars::ObservationFeatures>(buf.data());
+    return transformer->calc_observation(buf);
+}
+
+void WiFiHandler::updateObservations(const object::PacketClassifiedObject &obj, ObservationCache &cache) {
+    if (cache.computed && cache.amountAppended == obj.getAmountAppended()
+        && cache.amountRemoved == obj.getAmountRemoved())
+        return;
+    packet::PacketHistory history = obj.getHistory();
+    vector<size_t> &O = cache.observations;
+    if (obj.getStream() != nullptr) {
+        // streamed prefixes are in forward variables already, prefixes of raw tail are observed on copy of stream
+        O.clear();
+        features::StreamingFeatures stream = *obj.getStream();
+        for (size_t i = 0; i < history.size(); i++) {
+            stream.addPacket(history.getSizes()[i], history.getOffsets()[i], history.getArrivalTimes()[i]);
+            O.emplace_back(observe(stream));
+        }
+    } else {
+        // appends change only the last cached prefix, it can get fragment
+        size_t kept = 0;
+        if (cache.computed && cache.amountRemoved == obj.getAmountRemoved() && !O.empty())
+            kept = O.size() - 1;
+        features::PrefixFeatureEngine engine(history);
+        O.resize(kept);
+        O.reserve(history.size());
+        while (engine.next())
+            if (engine.size() > kept)
+                O.emplace_back(observe(engine));
+    }
+    cache.computed = true;
+    cache.amountAppended = obj.getAmountAppended();
+    cache.amountRemoved = obj.getAmountRemoved();
+}
+
+size_t WiFiHandler::predictState(const ObservationCache &cache) const {
+    if (cache.forward.empty())
+        return probModel->predict_state(cache.observations);
+    vector<double> alpha = cache.forward;
+    for (size_t o : cache.observations)
+        probModel->forward(alpha, o);
+    return probModel->predict_last_state(alpha);
+}
+
+void WiFiHandler::invalidateObservations() {
+    for (object::MacTable::id_t id = 0; id < observationCache.size(); id++) {
+        ObservationCache &cache = observationCache[id];
+        cache.computed = false;
+        cache.observations.clear();
+        cache.forward.clear();
+        if (cache.tracked && !cache.dirty) {
+            cache.dirty = true;
+            dirtyObjects.emplace_back(id);
+        }
     }
-    return O;
 }
 
 
+bool WiFiHandler::isClassified(object::MacTable::id_t id) const {
+    return id < alreadyClassified.size() && alreadyClassified[id].has_value();
+}
+
+void WiFiHandler::setResult(MAC_t mac, DevType type, uint8_t algo) {
+    pair<string, uint8_t> &res = classifiedObjects[mac];
+    res = {object::toString(type), algo};
+    allObjects[mac] = res;
+}
+
+void WiFiHandler::setClassified(object::MacTable::id_t id, DevType type, uint8_t algo) {
+    if (id >= alreadyClassified.size())
+        alreadyClassified.resize(macs->range());
+    alreadyClassified[id] = type;
+    MAC_t mac = macs->getMAC(id);
+    setResult(mac, type, algo);
+    notClassifiedObjects.erase(mac);
+    // Classified device doesn't get frames anymore
+    worker->release(id);
+    if (id < observationCache.size())
+        observationCache[id] = ObservationCache();
+}
+
+void WiFiHandler::touch(object::MacTable::id_t id) {
+    const vector<frames::worker::Worker::handle_t> &packetObjects = worker->getObjects();
+    if (id >= packetObjects.size() || packetObjects[id] == frames::worker::Worker::NONE) return;
+    if (id >= observationCache.size())
+        observationCache.resize(macs->range());
+    ObservationCache &cache = observationCache[id];
+    if (!cache.tracked) {
+        cache.tracked = true;
+        MAC_t mac = macs->getMAC(id);
+        pair<string, uint8_t> res = {object::toString(worker->getObject(packetObjects[id]).getType())
+                                     + ", недостаточно данных", 0};
+        notClassifiedObjects[mac] = res;
+        allObjects.insert({mac, res});
+    }
+    if (!cache.dirty) {
+        cache.dirty = true;
+        dirtyObjects.emplace_back(id);
+    }
+    // worker streams at most one packet per frame, so stream holds exactly its prefix
+    const features::StreamingFeatures *stream = worker->getObject(packetObjects[id]).getStream();
+    if (stream == nullptr || stream->size() == cache.streamedPackets) return;
+    cache.streamedPackets = stream->size();
+    if (transformer == nullptr || probModel == nullptr) return;
+    probModel->forward(cache.forward, observe(*stream));
+}
+
 void WiFiHandler::handleFrame(Frame &&frame) {
     if (!frame.getTA().has_value()) return;
     network->addFrame(frame);
     MAC_t mac = frame.getTA().value();
-    if (frameslib::utils::checkExist(mac, alreadyClassified)) return;
+    // Only classified devices and devices in worker get ids, other TAs aren't remembered
+    object::MacTable::id_t id = macs->find(mac);
+    if (id != object::MacTable::NONE && isClassified(id)) return;
     if (macClassifier->classify(mac, frame.getSSID())) {
-        alreadyClassified.insert({mac, macClassifier->getLastClassifiedObject()->getType()});
+        setClassified(macs->intern(mac), macClassifier->getLastClassifiedObject()->getType());
         return;
     }
-    worker->frameHandle(frame);
+    if (!frames::worker::Worker::isPacketFrame(frame)) return;
+    if (id == object::MacTable::NONE)
+        id = macs->intern(mac);
+    worker->frameHandle(frame, id);
+    touch(id);
 }
 
 void WiFiHandler::handleFrame(const string &header, const string &body) {
@@ -267,74 +511,78 @@ void WiFiHandler::handleFrame(const string &header, const string &body) {
 }
 
 std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> WiFiHandler::getClassifiedObjects() {
-    unordered_map<uint64_t , pair<string, uint8_t>> res_dict;
+    // Devices classified at the previous poll are reported as classified before
+    for (object::MacTable::id_t id : freshlyClassified)
+        setResult(macs->getMAC(id), alreadyClassified[id].value(), 1);
+    freshlyClassified.clear();
     if (!worker->isQueueEmpty()) {
         size_t n_rows = worker->getQueueSize();
-        vector<object::PacketClassifiedObject> result;
+        vector<frames::worker::Worker::handle_t> result;
+        vector<packet::PacketHistory> histories;
+        vector<const packet::PacketHistory *> batch;
         result.reserve(n_rows);
-        Matrix<double> tmp(n_rows, global_vars::n_features);
-        for (size_t i = 0; !worker->isQueueEmpty();  i++) {
-            shared_ptr<object::PacketClassifiedObject> query = worker->popFront();
-            result.emplace_back(*query);
-            vector<double> curFeatures = features::excludeFeaturesFromPackets(result.back().getPackets());
-            for (size_t j = 0; j < global_vars::n_features; j++)
-                tmp.set(i, j, curFeatures[j]);
-        }
-        Data queries(n_rows, global_vars::n_features, tmp, nullptr);
+        while (!worker->isQueueEmpty())
+            result.emplace_back(worker->popFront());
+        // streaming devices go last, their features come from streams
+        size_t n_exact = size_t(std::stable_partition(result.begin(), result.end(),
+            [this](frames::worker::Worker::handle_t handle) {
+                return worker->getObject(handle).getStream() == nullptr;
+            }) - result.begin());
+        histories.reserve(n_exact);
+        for (size_t i = 0; i < n_exact; i++)
+            histories.emplace_back(worker->getObject(result[i]).getHistory());
+        for (const packet::PacketHistory &history : histories)
+            batch.emplace_back(&history);
+        // features of all devices are written straight into rows of matrix
+        static_assert(std::is_same<global_vars::PacketFeatures, features::AllFeatures>::value,
+                      "FeatureBatch writes all features");
         vector<size_t> res(n_rows);
-        packetClassifier->predict(queries, res);
+        if (singlePrecision) {
+            Matrix<float> tmp(n_rows, global_vars::n_features);
+            if (n_exact > 0)
+                features::FeatureBatch(batch).calcFeatures(&tmp(0, 0), global_vars::n_features);
+            for (size_t i = n_exact; i < n_rows; i++)
+                writeStreamingFeatures(worker->getObject(result[i]), &tmp(i, 0));
+            packetClassifier->predict(tmp, res);
+        } else {
+            Matrix<double> tmp(n_rows, global_vars::n_features);
+            if (n_exact > 0)
+                features::FeatureBatch(batch).calcFeatures(&tmp(0, 0), global_vars::n_features);
+            for (size_t i = n_exact; i < n_rows; i++)
+                writeStreamingFeatures(worker->getObject(result[i]), &tmp(i, 0));
+            Data queries(n_rows, global_vars::n_features, tmp, nullptr);
+            packetClassifier->predict(queries, res);
+        }
         for (size_t i = 0; i < n_rows; i++) {
-            result[i].setType(object::DeviceType(res[i]));
-            alreadyClassified.insert({ result[i].getAddress(), result[i].getType() });
-            res_dict.insert({ result[i].getAddress(), {object::toString(result[i].getType()), 3}});
+            object::MacTable::id_t id = macs->find(worker->getObject(result[i]).getAddress());
+            setClassified(id, DevType(res[i]), 3);
+            freshlyClassified.emplace_back(id);
         }
     }
     // Добавление классификации объектов с недостаточным количеством пакетов
-    for (const auto& p : worker->getObjects())
-        if (p.first != graph::BROADCAST && !frameslib::utils::checkExist(p.first, alreadyClassified)) {
-            DevType pred = DevType(probModel->predict_state(getObservations(p.second)));
-            res_dict[p.first] = {object::toString(pred), 2};
-            alreadyClassified[p.first] = pred;
-        }
-    // Добавление классификации собеседников
-    unordered_map<MAC_t, pair<string, uint8_t>> addition = {};
-    for (const auto& p: alreadyClassified) {
-        if (p.second == frameslib::object::Unknown) continue;
-        tl::optional<uint64_t> client = network->getMostFrequentlyClient(p.first);
-        if (!client.has_value()) continue;
-        if (client.value() != graph::BROADCAST && !frameslib::utils::checkExist(client.value(), alreadyClassified)) {
-            uint8_t algo = 1;
-            if (frameslib::utils::checkExist(p.first, res_dict)) algo = res_dict[p.first].second;
-            addition.insert({client.value(), {object::toString(object::getOpposite(p.second)), algo}});
-        }
+    const vector<frames::worker::Worker::handle_t> &packetObjects = worker->getObjects();
+    for (object::MacTable::id_t id : dirtyObjects) {
+        ObservationCache &cache = observationCache[id];
+        cache.dirty = false;
+        if (id >= packetObjects.size() || packetObjects[id] == frames::worker::Worker::NONE || isClassified(id))
+            continue;
+        MAC_t mac = macs->getMAC(id);
+        if (mac == graph::BROADCAST) continue;
+        updateObservations(worker->getObject(packetObjects[id]), cache);
+        setClassified(id, DevType(predictState(cache)), 2);
+        freshlyClassified.emplace_back(id);
     }
-
-    // Агрегация результатов
-    for (const auto& p: alreadyClassified)
-        if (!frameslib::utils::checkExist(p.first, res_dict))
-            res_dict[p.first] = {object::toString(p.second), 1};
-    return std::move(res_dict);
+    dirtyObjects.clear();
+    return classifiedObjects;
 }
 
-std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> WiFiHandler::getNotClassifiedObjects() {
-    unordered_map<uint64_t , pair<string, uint8_t>> res;
-    unordered_map<uint64_t, shared_ptr<object::PacketClassifiedObject>> packetObjects = worker->getObjects();
-    for (const auto& obj : alreadyClassified)
-        if (frameslib::utils::checkExist(obj.first, packetObjects))
-            packetObjects.erase(obj.first);
-    res.reserve(packetObjects.size());
-    stringstream ss;
-    for (const auto& p: packetObjects)
-        res[p.first] = {object::toString(p.second->getType()) + ", недостаточно данных", 0};
-    return std::move(res);
+std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> WiFiHandler::getNotClassifiedObjects() const {
+    return notClassifiedObjects;
 }
 
 std::unordered_map<uint64_t, std::pair<std::string, uint8_t>> WiFiHandler::getAllObjects() {
-    unordered_map<uint64_t , pair<string, uint8_t>> res = getClassifiedObjects();
-    unordered_map<uint64_t , pair<string, uint8_t>> tmp = getNotClassifiedObjects();
-    res.reserve(res.size() + tmp.size());
-    res.insert(tmp.begin(), tmp.end());
-    return std::move(res);
+    getClassifiedObjects();
+    return allObjects;
 }
 
 string WiFiHandler::getStrWithClassifiedObjects() {
@@ -346,10 +594,41 @@ string WiFiHandler::getStrWithClassifiedObjects() {
     return ss.str();
 }
 
-void WiFiHandler::setTransformer(unique_ptr<transformer_t> transformer) {
+bool WiFiHandler::setTransformer(unique_ptr<transformer_t> transformer) {
+    if (transformer == nullptr || transformer->features_amount() != global_vars::ObservationFeatures::size)
+        return false;
     WiFiHandler::transformer = std::move(transformer);
+    invalidateObservations();
+    return true;
 }
 
 void WiFiHandler::setProbModel(unique_ptr<ProbModel> probModel) {
     WiFiHandler::probModel = std::move(probModel);
+    invalidateObservations();
+}
+
+bool WiFiHandler::loadModels(const string &path) {
+    auto reader = make_shared<model_file::reader_t>();
+    if (!reader->open(path)) return false;
+    auto estimator = make_unique<PacketEstimator>();
+    auto newTransformer = make_unique<transformer_t>();
+    auto newProbModel = make_unique<ProbModel>();
+    if (!estimator->load_binary(reader) || !newTransformer->load_binary(*reader) || !newProbModel->load_binary(*reader)
+    || !fitsPacketFeatures(*estimator)
+    || newTransformer->features_amount() != global_vars::ObservationFeatures::size)
+        return false;
+    setPacketClassifier(std::move(estimator));
+    setTransformer(std::move(newTransformer));
+    setProbModel(std::move(newProbModel));
+    return true;
+}
+
+void WiFiHandler::setStreaming(bool enable) {
+    worker->setStreaming(enable);
+}
+
+void WiFiHandler::setSinglePrecision(bool enable) {
+    if (singlePrecision != enable)
+        invalidateObservations();
+    singlePrecision = enable;
 }